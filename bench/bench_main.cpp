@@ -0,0 +1,591 @@
+// rendermatic_bench — microbenchmarks for the per-frame CPU kernels.
+//
+// Emits one JSON document (to stdout or --json <file>) so results can be
+// archived per release and diffed for regressions. A human-readable table
+// is printed to stderr.
+
+#include "frame_queue.h"
+#include "frame_pool.h"
+#include "pixel_ops.h"
+#include "loader.h"
+#include "ndireceiver.h"
+#include "ndi_multiview.h"
+#include "ndi_stub.h"
+#include "splash_screen.h"
+#include "texture.h"
+#include "test_pattern_source.h"
+#include <json/json.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Set by cases that verify invariants; makes the process exit non-zero
+bool g_failed = false;
+
+struct Resolution {
+    const char* name;
+    int width;
+    int height;
+};
+
+const Resolution RESOLUTIONS[] = {
+    { "720p",  1280,  720 },
+    { "1080p", 1920, 1080 },
+    { "4k",    3840, 2160 },
+};
+
+struct Options {
+    std::string filter;
+    std::string jsonPath;
+    int minIterations = 5;
+    double minSeconds = 0.5;
+};
+
+struct Result {
+    std::string name;
+    std::string resolution;
+    int width = 0;
+    int height = 0;
+    int iterations = 0;
+    double medianNs = 0;
+    double minNs = 0;
+    double bytesPerIteration = 0;
+};
+
+std::vector<unsigned char> makePattern(size_t size) {
+    std::vector<unsigned char> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = static_cast<unsigned char>((i * 131) ^ (i >> 7));
+    return data;
+}
+
+// Run `fn` until both the iteration and time minimums are met.
+// Reports median and best per-iteration wall time.
+Result measure(const std::string& name, const Resolution& res, double bytes,
+               const Options& opts, const std::function<void()>& fn) {
+    fn(); // warm-up (page faults, caches, lazy init)
+
+    std::vector<double> samples;
+    auto begin = std::chrono::steady_clock::now();
+    while (true) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        auto t1 = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+
+        double total = std::chrono::duration<double>(t1 - begin).count();
+        if ((int)samples.size() >= opts.minIterations && total >= opts.minSeconds)
+            break;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    Result r;
+    r.name = name;
+    r.resolution = res.name;
+    r.width = res.width;
+    r.height = res.height;
+    r.iterations = static_cast<int>(samples.size());
+    r.medianNs = samples[samples.size() / 2];
+    r.minNs = samples.front();
+    r.bytesPerIteration = bytes;
+    return r;
+}
+
+bool selected(const Options& opts, const std::string& name) {
+    return opts.filter.empty() || name.find(opts.filter) != std::string::npos;
+}
+
+// --- Cases ---
+
+void benchInterleave(const Options& opts, std::vector<Result>& out) {
+    for (const auto& res : RESOLUTIONS) {
+        int cw = res.width / 2;
+        int ch = res.height / 2;
+        // Decoder planes usually carry alignment padding
+        int stride = (cw + 63) & ~63;
+        auto u = makePattern(static_cast<size_t>(stride) * ch);
+        auto v = makePattern(static_cast<size_t>(stride) * ch);
+        std::vector<unsigned char> dst(static_cast<size_t>(cw) * ch * 2);
+        out.push_back(measure("yuv420p_interleave_uv", res, (double)dst.size(), opts, [&] {
+            PixelOps::interleaveUV(dst.data(), u.data(), stride, v.data(), stride, cw, ch);
+        }));
+    }
+}
+
+void benchYuv420pToNv12(const Options& opts, std::vector<Result>& out) {
+    // decoderLoop software path for renderers without a three-plane path:
+    // Y row copy + UV interleave into a pooled buffer
+    for (const auto& res : RESOLUTIONS) {
+        int w = res.width, h = res.height;
+        int yStride = (w + 63) & ~63;
+        int cStride = (w / 2 + 63) & ~63;
+        auto y = makePattern(static_cast<size_t>(yStride) * h);
+        auto u = makePattern(static_cast<size_t>(cStride) * (h / 2));
+        auto v = makePattern(static_cast<size_t>(cStride) * (h / 2));
+        size_t ySize = (size_t)w * h;
+        size_t total = ySize + (size_t)(w / 2) * (h / 2) * 2;
+        FramePool pool;
+        out.push_back(measure("yuv420p_to_nv12_frame", res, (double)total, opts, [&] {
+            auto buf = pool.acquire(total);
+            PixelOps::copyPlane(buf->data(), w, y.data(), yStride, w, h);
+            PixelOps::interleaveUV(buf->data() + ySize, u.data(), cStride, v.data(), cStride, w / 2, h / 2);
+            Texture tex;
+            tex.setSharedPixels(buf, buf->data(), w, h, 1, ColorFormat::NV12);
+        }));
+    }
+}
+
+void benchYuv420pToPlanar(const Options& opts, std::vector<Result>& out) {
+    // decoderLoop software path for renderers with native YUV420P upload
+    for (const auto& res : RESOLUTIONS) {
+        int w = res.width, h = res.height;
+        int yStride = (w + 63) & ~63;
+        int cStride = (w / 2 + 63) & ~63;
+        auto y = makePattern(static_cast<size_t>(yStride) * h);
+        auto u = makePattern(static_cast<size_t>(cStride) * (h / 2));
+        auto v = makePattern(static_cast<size_t>(cStride) * (h / 2));
+        size_t ySize = (size_t)w * h;
+        size_t cSize = (size_t)(w / 2) * (h / 2);
+        size_t total = ySize + cSize * 2;
+        FramePool pool;
+        out.push_back(measure("yuv420p_planar_frame", res, (double)total, opts, [&] {
+            auto buf = pool.acquire(total);
+            PixelOps::copyPlane(buf->data(), w, y.data(), yStride, w, h);
+            PixelOps::copyPlane(buf->data() + ySize, w / 2, u.data(), cStride, w / 2, h / 2);
+            PixelOps::copyPlane(buf->data() + ySize + cSize, w / 2, v.data(), cStride, w / 2, h / 2);
+            Texture tex;
+            tex.setSharedPixels(buf, buf->data(), w, h, 1, ColorFormat::YUV420P);
+        }));
+    }
+}
+
+void benchSwizzleRotate(const Options& opts, std::vector<Result>& out) {
+    for (const auto& res : RESOLUTIONS) {
+        size_t pixels = (size_t)res.width * res.height;
+        auto src = makePattern(pixels * 4);
+        std::vector<uint32_t> dst(pixels);
+        for (int rot = 0; rot < 4; rot++) {
+            int outW = (rot & 1) ? res.height : res.width;
+            std::string name = "dfb_swizzle_rotate_" + std::to_string(rot * 90);
+            out.push_back(measure(name, res, (double)pixels * 4, opts, [&] {
+                PixelOps::swizzleRotateRGBAtoARGB(dst.data(), outW * 4,
+                                                  reinterpret_cast<const uint32_t*>(src.data()), res.width * 4,
+                                                  res.width, res.height, rot);
+            }));
+        }
+    }
+}
+
+// Scalar references for the downscale kernels. The 2x2 box rounds exactly
+// like PixelOps (vertical pairs first); the area average is computed in
+// floating point, so the fixed-point kernel may differ by rounding.
+std::vector<unsigned char> halveReference(const unsigned char* src, int srcW, int srcH) {
+    int outW = srcW / 2;
+    int outH = srcH / 2;
+    std::vector<unsigned char> out((size_t)outW * outH * 4);
+    for (int y = 0; y < outH; y++) {
+        const unsigned char* top = src + (size_t)y * 2 * srcW * 4;
+        const unsigned char* bottom = top + (size_t)srcW * 4;
+        for (int x = 0; x < outW; x++) {
+            for (int i = 0; i < 4; i++) {
+                unsigned even = (top[x * 8 + i] + bottom[x * 8 + i] + 1) >> 1;
+                unsigned odd = (top[x * 8 + 4 + i] + bottom[x * 8 + 4 + i] + 1) >> 1;
+                out[((size_t)y * outW + x) * 4 + i] = (unsigned char)((even + odd + 1) >> 1);
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<unsigned char> areaReference(const unsigned char* src, int srcW, int srcH, int dstW, int dstH) {
+    auto coverage = [](int srcSize, int dstSize, int i, int s) {
+        double ratio = (double)srcSize / dstSize;
+        return std::max(0.0, std::min((i + 1) * ratio, s + 1.0) - std::max(i * ratio, (double)s)) / ratio;
+    };
+    std::vector<unsigned char> out((size_t)dstW * dstH * 4);
+    double ry = (double)srcH / dstH;
+    double rx = (double)srcW / dstW;
+    for (int y = 0; y < dstH; y++) {
+        for (int x = 0; x < dstW; x++) {
+            double sum[4] = {};
+            for (int sy = (int)(y * ry); sy < std::min(srcH, (int)std::ceil((y + 1) * ry)); sy++) {
+                double wy = coverage(srcH, dstH, y, sy);
+                for (int sx = (int)(x * rx); sx < std::min(srcW, (int)std::ceil((x + 1) * rx)); sx++) {
+                    double w = wy * coverage(srcW, dstW, x, sx);
+                    for (int i = 0; i < 4; i++) sum[i] += w * src[((size_t)sy * srcW + sx) * 4 + i];
+                }
+            }
+            for (int i = 0; i < 4; i++)
+                out[((size_t)y * dstW + x) * 4 + i] = (unsigned char)std::clamp((int)(sum[i] + 0.5), 0, 255);
+        }
+    }
+    return out;
+}
+
+// Largest per-channel difference between `actual` and `expected`
+int maxDifference(const std::vector<unsigned char>& actual, const std::vector<unsigned char>& expected) {
+    int worst = 0;
+    for (size_t i = 0; i < expected.size(); i++)
+        worst = std::max(worst, std::abs((int)actual[i] - (int)expected[i]));
+    return worst;
+}
+
+// Compare the SIMD kernels with the scalar references on a `width` x `height`
+// pattern; odd sizes exercise the scalar tails next to the vector loops
+void checkImageDownscale(const char* label, int width, int height) {
+    constexpr int AREA_TOLERANCE = 1;   // fixed point vs floating point rounding
+    auto src = makePattern((size_t)width * height * 4);
+
+    std::vector<unsigned char> half((size_t)(width / 2) * (height / 2) * 4);
+    PixelOps::halveRGBA(half.data(), (width / 2) * 4, src.data(), width * 4, width, height);
+    int halveDiff = maxDifference(half, halveReference(src.data(), width, height));
+    if (halveDiff != 0) {
+        std::cerr << "image_halve: " << label << " differs from the scalar reference by " << halveDiff << "\n";
+        g_failed = true;
+    }
+
+    int areaW = width * 2 / 3;
+    int areaH = height * 2 / 3;
+    std::vector<unsigned char> area((size_t)areaW * areaH * 4);
+    PixelOps::areaDownscaleRGBA(area.data(), areaW * 4, src.data(), width * 4, width, height, areaW, areaH);
+    int areaDiff = maxDifference(area, areaReference(src.data(), width, height, areaW, areaH));
+    if (areaDiff > AREA_TOLERANCE) {
+        std::cerr << "image_area_2_3: " << label << " differs from the scalar reference by " << areaDiff << "\n";
+        g_failed = true;
+    }
+}
+
+void benchImageDownscale(const Options& opts, std::vector<Result>& out) {
+    checkImageDownscale("317x211", 317, 211);
+
+    // Decode-time downscale kernels on an RGBA image of each resolution:
+    // one 2x2 box pass, and the area pass that finishes a non-power-of-two fit
+    for (const auto& res : RESOLUTIONS) {
+        checkImageDownscale(res.name, res.width, res.height);
+        size_t pixels = (size_t)res.width * res.height;
+        auto src = makePattern(pixels * 4);
+        std::vector<unsigned char> dst(pixels * 4);
+        out.push_back(measure("image_halve", res, (double)pixels * 4, opts, [&] {
+            PixelOps::halveRGBA(dst.data(), (res.width / 2) * 4, src.data(), res.width * 4,
+                                res.width, res.height);
+        }));
+        int areaW = res.width * 2 / 3;
+        int areaH = res.height * 2 / 3;
+        out.push_back(measure("image_area_2_3", res, (double)pixels * 4, opts, [&] {
+            PixelOps::areaDownscaleRGBA(dst.data(), areaW * 4, src.data(), res.width * 4,
+                                        res.width, res.height, areaW, areaH);
+        }));
+    }
+}
+
+// Runs `body` against a receiver connected to the stub runtime, then checks
+// that every frame went back to the SDK and instances were destroyed last.
+void withStubReceiver(const Resolution& res, bool frameSync, const std::function<void(NDIReceiver&)>& body) {
+    // The receiver logs to stdout; keep stdout clean for the JSON report
+    std::streambuf* coutBuf = std::cout.rdbuf(std::cerr.rdbuf());
+    ndi_stub::configure(res.width, res.height);
+    {
+        NDIReceiver receiver;
+        receiver.attachRuntime(ndi_stub::table());
+        receiver.setFrameSync(frameSync);
+        receiver.setSource(ndi_stub::SOURCE_NAME);
+        receiver.start();
+        while (!receiver.isConnected())
+            std::this_thread::yield();
+        body(receiver);
+        receiver.stop();
+    }
+    std::cout.rdbuf(coutBuf);
+
+    auto& stub = ndi_stub::state();
+    if (!ndi_stub::balanced()) {
+        std::cerr << "ndi: " << res.name << (frameSync ? " (framesync)" : "")
+                  << " leaked (frames " << stub.captured << "/" << stub.freed
+                  << ", bad frees " << stub.badFrees
+                  << ", receivers " << stub.receiversCreated << "/" << stub.receiversDestroyed
+                  << ", framesyncs " << stub.frameSyncsCreated << "/" << stub.frameSyncsDestroyed << ")\n";
+        g_failed = true;
+    }
+}
+
+void benchNdiReceive(const Options& opts, std::vector<Result>& out) {
+    // Real NDIReceiver against the stub runtime: UYVY with a padded stride is
+    // handed to the render side by reference. One iteration = 60 distinct
+    // frames observed through getLatestFrame(), each held like a render tick.
+    constexpr int FRAMES = 60;
+    for (const auto& res : RESOLUTIONS) {
+        withStubReceiver(res, false, [&](NDIReceiver& receiver) {
+            double frameBytes = (double)ndi_stub::state().stride * res.height;
+            out.push_back(measure("ndi_receive_handoff_60", res, frameBytes * FRAMES, opts, [&] {
+                int last = -1;
+                int seen = 0;
+                while (seen < FRAMES) {
+                    Texture frame;
+                    if (receiver.getLatestFrame(frame) && frame.pixels[0] != last) {
+                        last = frame.pixels[0];
+                        seen++;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            }));
+        });
+    }
+}
+
+void benchNdiFrameSync(const Options& opts, std::vector<Result>& out) {
+    // FrameSync pull from the render side: one iteration = 60 display ticks
+    constexpr int TICKS = 60;
+    for (const auto& res : RESOLUTIONS) {
+        withStubReceiver(res, true, [&](NDIReceiver& receiver) {
+            while (!receiver.isFrameSyncActive())
+                std::this_thread::yield();
+            // Nothing is copied, so report time only
+            out.push_back(measure("ndi_framesync_pull_60", res, 0.0, opts, [&] {
+                for (int i = 0; i < TICKS; i++) {
+                    Texture frame;
+                    receiver.getLatestFrame(frame);
+                }
+            }));
+        });
+    }
+}
+
+void benchNdiMultiview(const Options& opts, std::vector<Result>& out) {
+    // 2x2 and 3x3 tiles on a 1080p output, sharing one stub runtime. One
+    // iteration = 60 render ticks collecting the latest frame of every tile.
+    constexpr int TICKS = 60;
+    const Resolution preview = { "360p", 640, 360 };
+    std::streambuf* coutBuf = std::cout.rdbuf(std::cerr.rdbuf());
+    for (int columns : { 2, 3 }) {
+        ndi_stub::configure(preview.width, preview.height, columns * columns * 4);
+        {
+            NDIReceiver runtime;
+            runtime.attachRuntime(ndi_stub::table());
+            NDIMultiview multiview(runtime);
+            std::vector<std::string> sources(columns * columns, ndi_stub::SOURCE_NAME);
+            std::string error;
+            multiview.start(sources, columns, 1920, 1080, error);
+
+            int cols = 0;
+            int rows = 0;
+            bool allConnected = false;
+            while (!allConnected) {
+                allConnected = true;
+                for (const auto& tile : multiview.getStatus(cols, rows))
+                    allConnected &= tile.connected;
+                std::this_thread::yield();
+            }
+
+            std::string name = "ndi_multiview_" + std::to_string(columns) + "x" + std::to_string(columns) + "_60";
+            std::vector<Texture> tiles;
+            out.push_back(measure(name, preview, 0.0, opts, [&] {
+                for (int i = 0; i < TICKS; i++) {
+                    multiview.getTiles(tiles, cols, rows);
+                    tiles.clear();
+                }
+            }));
+            multiview.stop();
+        }
+        if (!ndi_stub::balanced()) {
+            auto& stub = ndi_stub::state();
+            std::cerr << "ndi_multiview: " << columns << "x" << columns << " leaked (frames "
+                      << stub.captured << "/" << stub.freed << ", receivers "
+                      << stub.receiversCreated << "/" << stub.receiversDestroyed << ")\n";
+            g_failed = true;
+        }
+    }
+    std::cout.rdbuf(coutBuf);
+}
+
+void benchFrameQueue(const Options& opts, std::vector<Result>& out) {
+    // Producer thread pushes NV12 frames (blocking, like file playback) while
+    // the calling thread consumes with getNext(). One iteration = 60 frames.
+    constexpr int FRAMES = 60;
+    for (const auto& res : RESOLUTIONS) {
+        size_t frameSize = (size_t)res.width * res.height * 3 / 2;
+        auto pattern = makePattern(frameSize);
+        out.push_back(measure("frame_queue_push_pop_60", res, (double)frameSize * FRAMES, opts, [&] {
+            FrameQueue queue;
+            std::thread producer([&] {
+                for (int i = 0; i < FRAMES; i++) {
+                    Texture tex;
+                    tex.setOwnedPixels(std::vector<unsigned char>(pattern), res.width, res.height, 1, ColorFormat::NV12);
+                    queue.push(i / 60.0, std::move(tex), true);
+                }
+            });
+            int consumed = 0;
+            Texture frame;
+            while (consumed < FRAMES) {
+                if (queue.getNext(frame)) consumed++;
+                else std::this_thread::yield();
+            }
+            producer.join();
+        }));
+    }
+}
+
+void benchSplashOverlay(const Options& opts, std::vector<Result>& out) {
+    SplashScreen::Info info;
+    info.instanceName = "rendermatic-bench01";
+    info.ipAddress = "192.168.100.200";
+    for (const auto& res : RESOLUTIONS) {
+        out.push_back(measure("splash_generate_overlay", res, (double)res.width * res.height * 4, opts, [&] {
+            Texture overlay = SplashScreen::generateOverlay(res.width, res.height, info);
+        }));
+    }
+}
+
+void benchLoadTexture(const Options& opts, std::vector<Result>& out) {
+    // Uses the bundled media; reports the image's native resolution
+    const char* files[] = { "default.jpg", "safety_cat_ears.png" };
+    for (const char* file : files) {
+        Loader loader;
+        Texture probe;
+        try {
+            probe = loader.LoadTexture(file);
+        } catch (const std::exception& e) {
+            std::cerr << "Skipping load_texture " << file << ": " << e.what() << std::endl;
+            continue;
+        }
+        Resolution res = { file, probe.width, probe.height };
+        std::string ext = std::filesystem::path(file).extension().string().substr(1);
+        out.push_back(measure("load_texture_" + ext, res, (double)probe.width * probe.height * 4, opts, [&] {
+            Texture tex = loader.LoadTexture(file);
+        }));
+        // Decoded for a 720p display, as the texture manager does
+        out.push_back(measure("load_texture_" + ext + "_720p", res, (double)probe.width * probe.height * 4, opts, [&] {
+            Texture tex = loader.LoadTexture(file, ColorFormat::RGBA, 1280, 720);
+        }));
+    }
+}
+
+void benchTestPattern(const Options& opts, std::vector<Result>& out) {
+    // Per-frame cost of the testsrc:// generator plus the render-loop stamp read
+    for (const auto& res : RESOLUTIONS) {
+        TestPatternSource::Params params;
+        params.width = res.width;
+        params.height = res.height;
+        TestPatternSource source(params);
+        uint32_t n = 0;
+        double bytes = (double)res.width * res.height * 3 / 2;
+        out.push_back(measure("test_pattern_generate_nv12", res, bytes, opts, [&] {
+            Texture frame = source.generate(n++, TestPatternSource::nowMs());
+            uint32_t index, stamp;
+            TestPatternSource::readStamp(frame, index, stamp);
+        }));
+    }
+}
+
+void printUsage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [--filter <substr>] [--json <file>] [--min-time <seconds>] [--min-iterations <n>]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            opts.filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            opts.jsonPath = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            opts.minSeconds = std::atof(argv[++i]);
+        } else if (arg == "--min-iterations" && i + 1 < argc) {
+            opts.minIterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            printUsage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    // Run from the executable's directory so media/ resolves like the main app
+    std::string exeDir = std::filesystem::path(argv[0]).parent_path().string();
+    if (!exeDir.empty()) {
+        try {
+            std::filesystem::current_path(exeDir);
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: Could not change to executable directory: " << e.what() << std::endl;
+        }
+    }
+
+    struct Case {
+        const char* name;
+        void (*run)(const Options&, std::vector<Result>&);
+    };
+    const Case cases[] = {
+        { "frame_queue",          benchFrameQueue },
+        { "yuv420p_interleave",   benchInterleave },
+        { "yuv420p_to_nv12",      benchYuv420pToNv12 },
+        { "yuv420p_planar",       benchYuv420pToPlanar },
+        { "dfb_swizzle_rotate",   benchSwizzleRotate },
+        { "image_downscale",      benchImageDownscale },
+        { "load_texture",         benchLoadTexture },
+        { "splash_overlay",       benchSplashOverlay },
+        { "ndi_receive",          benchNdiReceive },
+        { "ndi_framesync",        benchNdiFrameSync },
+        { "ndi_multiview",        benchNdiMultiview },
+        { "test_pattern",         benchTestPattern },
+    };
+
+    std::vector<Result> results;
+    for (const auto& c : cases) {
+        if (selected(opts, c.name)) c.run(opts, results);
+    }
+
+    Json::Value root;
+    root["benchmark"] = "rendermatic_bench";
+    root["timestamp"] = static_cast<Json::Int64>(
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    root["hardwareThreads"] = std::thread::hardware_concurrency();
+    root["results"] = Json::arrayValue;
+
+    fprintf(stderr, "%-28s %-20s %6s %12s %12s %10s\n",
+            "case", "resolution", "iters", "median_us", "min_us", "MB/s");
+    for (const auto& r : results) {
+        double mbps = r.medianNs > 0 ? (r.bytesPerIteration / (1024.0 * 1024.0)) / (r.medianNs / 1e9) : 0.0;
+        fprintf(stderr, "%-28s %-20s %6d %12.1f %12.1f %10.1f\n",
+                r.name.c_str(), r.resolution.c_str(), r.iterations,
+                r.medianNs / 1000.0, r.minNs / 1000.0, mbps);
+
+        Json::Value entry;
+        entry["name"] = r.name;
+        entry["resolution"] = r.resolution;
+        entry["width"] = r.width;
+        entry["height"] = r.height;
+        entry["iterations"] = r.iterations;
+        entry["medianNs"] = r.medianNs;
+        entry["minNs"] = r.minNs;
+        entry["bytesPerIteration"] = r.bytesPerIteration;
+        entry["mbPerSecond"] = mbps;
+        root["results"].append(entry);
+    }
+
+    Json::StyledWriter writer;
+    std::string json = writer.write(root);
+    if (opts.jsonPath.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream file(opts.jsonPath);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open " << opts.jsonPath << " for writing" << std::endl;
+            return 1;
+        }
+        file << json;
+    }
+    return g_failed ? 1 : 0;
+}
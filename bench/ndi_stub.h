@@ -0,0 +1,176 @@
+#pragma once
+// In-process stand-in for the NDI runtime, so the receiver's real capture and
+// release path can be benchmarked (and checked for leaks) without libndi.
+// One source, "BENCH (stub)", delivering UYVY frames with a padded stride.
+
+#include "ndi/Processing.NDI.Lib.h"
+#include "ndi/Processing.NDI.DynamicLoad.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ndi_stub {
+
+inline const char* SOURCE_NAME = "BENCH (stub)";
+
+struct State {
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+
+    std::mutex mutex;
+    std::vector<std::vector<uint8_t>> buffers;   // frame buffers owned by the "SDK"
+    std::vector<uint8_t*> freeBuffers;
+
+    std::atomic<int64_t> sequence{0};
+    std::atomic<int64_t> captured{0};
+    std::atomic<int64_t> freed{0};
+    std::atomic<int64_t> badFrees{0};            // frees of buffers not handed out
+    std::atomic<int> receiversCreated{0};
+    std::atomic<int> receiversDestroyed{0};
+    std::atomic<int> frameSyncsCreated{0};
+    std::atomic<int> frameSyncsDestroyed{0};
+};
+
+inline State& state() {
+    static State s;
+    return s;
+}
+
+// Prepare `poolSize` SDK-side buffers for width x height UYVY frames
+inline void configure(int width, int height, int poolSize = 4) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.width = width;
+    s.height = height;
+    s.stride = width * 2 + 128;
+    s.buffers.assign(poolSize, std::vector<uint8_t>((size_t)s.stride * height, 0x80));
+    s.freeBuffers.clear();
+    for (auto& b : s.buffers) s.freeBuffers.push_back(b.data());
+    s.sequence = 0;
+    s.captured = 0;
+    s.freed = 0;
+    s.badFrees = 0;
+    s.receiversCreated = 0;
+    s.receiversDestroyed = 0;
+    s.frameSyncsCreated = 0;
+    s.frameSyncsDestroyed = 0;
+}
+
+// True when every frame, receiver and frame-sync handed out was returned
+inline bool balanced() {
+    State& s = state();
+    return s.captured == s.freed && s.badFrees == 0 &&
+           s.receiversCreated == s.receiversDestroyed &&
+           s.frameSyncsCreated == s.frameSyncsDestroyed;
+}
+
+inline bool initialize() { return true; }
+inline void destroy() {}
+inline const char* version() { return "stub"; }
+
+inline NDIlib_find_instance_t findCreate(const NDIlib_find_create_t*) {
+    static int instance;
+    return reinterpret_cast<NDIlib_find_instance_t>(&instance);
+}
+inline void findDestroy(NDIlib_find_instance_t) {}
+// The source list never changes after the first query
+inline bool findWait(NDIlib_find_instance_t, uint32_t timeoutMs) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::min<uint32_t>(timeoutMs, 20)));
+    return false;
+}
+inline const NDIlib_source_t* findSources(NDIlib_find_instance_t, uint32_t* count) {
+    static NDIlib_source_t source;
+    source.p_ndi_name = SOURCE_NAME;
+    *count = 1;
+    return &source;
+}
+
+inline NDIlib_recv_instance_t recvCreate(const NDIlib_recv_create_v3_t*) {
+    static int instance;
+    state().receiversCreated++;
+    return reinterpret_cast<NDIlib_recv_instance_t>(&instance);
+}
+inline void recvDestroy(NDIlib_recv_instance_t) { state().receiversDestroyed++; }
+
+// Hands out the next free buffer; reports no frame while all are held,
+// like a sender whose frames are not being returned.
+inline NDIlib_frame_type_e recvCapture(NDIlib_recv_instance_t, NDIlib_video_frame_v2_t* video,
+                                       NDIlib_audio_frame_v3_t*, NDIlib_metadata_frame_t*, uint32_t) {
+    State& s = state();
+    if (!video) return NDIlib_frame_type_none;
+    uint8_t* data = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.freeBuffers.empty()) return NDIlib_frame_type_none;
+        data = s.freeBuffers.front();
+        s.freeBuffers.erase(s.freeBuffers.begin());
+    }
+    *video = NDIlib_video_frame_v2_t(s.width, s.height, NDIlib_FourCC_type_UYVY);
+    video->p_data = data;
+    video->line_stride_in_bytes = s.stride;
+    video->timecode = s.sequence++;
+    // First byte carries the low bits of the frame counter
+    data[0] = static_cast<uint8_t>(video->timecode);
+    s.captured++;
+    return NDIlib_frame_type_video;
+}
+
+inline void recvFreeVideo(NDIlib_recv_instance_t, const NDIlib_video_frame_v2_t* video) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    bool known = false;
+    for (auto& b : s.buffers) known |= (b.data() == video->p_data);
+    if (!known) {
+        s.badFrees++;
+        return;
+    }
+    s.freeBuffers.push_back(video->p_data);
+    s.freed++;
+}
+
+inline NDIlib_framesync_instance_t frameSyncCreate(NDIlib_recv_instance_t) {
+    static int instance;
+    state().frameSyncsCreated++;
+    return reinterpret_cast<NDIlib_framesync_instance_t>(&instance);
+}
+inline void frameSyncDestroy(NDIlib_framesync_instance_t) { state().frameSyncsDestroyed++; }
+
+// Always returns immediately; an empty frame when no buffer is free
+inline void frameSyncCaptureVideo(NDIlib_framesync_instance_t, NDIlib_video_frame_v2_t* video,
+                                  NDIlib_frame_format_type_e) {
+    if (recvCapture(nullptr, video, nullptr, nullptr, 0) != NDIlib_frame_type_video)
+        *video = NDIlib_video_frame_v2_t();
+}
+inline void frameSyncFreeVideo(NDIlib_framesync_instance_t, NDIlib_video_frame_v2_t* video) {
+    if (video->p_data) recvFreeVideo(nullptr, video);
+}
+
+// Function table with only the entry points the receiver uses
+inline const NDIlib_v6* table() {
+    static NDIlib_v6 lib = [] {
+        NDIlib_v6 t = {};
+        t.initialize = initialize;
+        t.destroy = destroy;
+        t.version = version;
+        t.find_create_v2 = findCreate;
+        t.find_destroy = findDestroy;
+        t.find_wait_for_sources = findWait;
+        t.find_get_current_sources = findSources;
+        t.recv_create_v3 = recvCreate;
+        t.recv_destroy = recvDestroy;
+        t.recv_capture_v3 = recvCapture;
+        t.recv_free_video_v2 = recvFreeVideo;
+        t.framesync_create = frameSyncCreate;
+        t.framesync_destroy = frameSyncDestroy;
+        t.framesync_capture_video = frameSyncCaptureVideo;
+        t.framesync_free_video = frameSyncFreeVideo;
+        return t;
+    }();
+    return &lib;
+}
+
+} // namespace ndi_stub
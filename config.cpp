@@ -89,6 +89,16 @@ Configuration Configuration::loadFromFile(const std::string& path) {
                 config.monitorIndex = root.get("monitorIndex", 0).asInt();
                 config.ndiMode = root.get("ndiMode", false).asBool();
                 config.ndiSourceName = root.get("ndiSourceName", "").asString();
+                config.ndiFrameSync = root.get("ndiFrameSync", false).asBool();
+                for (const auto& source : root["ndiMultiviewSources"]) {
+                    config.ndiMultiviewSources.push_back(source.asString());
+                }
+                config.ndiMultiviewColumns = root.get("ndiMultiviewColumns", 0).asInt();
+                config.ndiOutputEnabled = root.get("ndiOutputEnabled", false).asBool();
+                config.ndiOutputName = root.get("ndiOutputName", config.ndiOutputName).asString();
+                config.ndiOutputWidth = root.get("ndiOutputWidth", config.ndiOutputWidth).asInt();
+                config.ndiOutputHeight = root.get("ndiOutputHeight", config.ndiOutputHeight).asInt();
+                config.ndiOutputFps = root.get("ndiOutputFps", config.ndiOutputFps).asInt();
                 config.backend = root.get("backend", "glfw").asString();
                 config.width = root.get("width", 1920).asInt();
                 config.height = root.get("height", 1080).asInt();
@@ -101,6 +111,8 @@ Configuration Configuration::loadFromFile(const std::string& path) {
                 config.splashDurationSeconds = root.get("splashDurationSeconds", 5).asInt();
                 config.displayRotation = root.get("displayRotation", 0).asInt();
                 config.targetFps = root.get("targetFps", 60).asInt();
+                config.textureCacheMB = root.get("textureCacheMB", config.textureCacheMB).asInt();
+                config.imageDiskCacheMB = root.get("imageDiskCacheMB", config.imageDiskCacheMB).asInt();
                 config.logLevel = root.get("logLevel", "info").asString();
             }
         }
@@ -134,6 +146,17 @@ bool Configuration::saveToFile(const std::string& path) const {
         root["monitorIndex"] = monitorIndex;
         root["ndiMode"] = ndiMode;
         root["ndiSourceName"] = ndiSourceName;
+        root["ndiFrameSync"] = ndiFrameSync;
+        root["ndiMultiviewSources"] = Json::arrayValue;
+        for (const auto& source : ndiMultiviewSources) {
+            root["ndiMultiviewSources"].append(source);
+        }
+        root["ndiMultiviewColumns"] = ndiMultiviewColumns;
+        root["ndiOutputEnabled"] = ndiOutputEnabled;
+        root["ndiOutputName"] = ndiOutputName;
+        root["ndiOutputWidth"] = ndiOutputWidth;
+        root["ndiOutputHeight"] = ndiOutputHeight;
+        root["ndiOutputFps"] = ndiOutputFps;
         root["backend"] = backend;
         root["width"] = width;
         root["height"] = height;
@@ -146,6 +169,8 @@ bool Configuration::saveToFile(const std::string& path) const {
         root["splashDurationSeconds"] = splashDurationSeconds;
         root["displayRotation"] = displayRotation;
         root["targetFps"] = targetFps;
+        root["textureCacheMB"] = textureCacheMB;
+        root["imageDiskCacheMB"] = imageDiskCacheMB;
         root["logLevel"] = logLevel;
         
         std::ofstream file(path);
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <cstdint>
+#include <vector>
 
 struct Configuration {
     bool fullscreen = true;
@@ -8,6 +9,14 @@ struct Configuration {
     int monitorIndex = 0;
     bool ndiMode = false;
     std::string ndiSourceName = "";  // NDI source to connect to (empty = idle, no auto-connect)
+    bool ndiFrameSync = false;       // Pull NDI frames via FrameSync at display cadence
+    std::vector<std::string> ndiMultiviewSources;  // Multiview tiles (empty = multiview off)
+    int ndiMultiviewColumns = 0;     // 2 or 3; 0 = pick from the source count
+    bool ndiOutputEnabled = false;   // Publish the program output as an NDI source
+    std::string ndiOutputName = "Rendermatic";
+    int ndiOutputWidth = 640;        // Program output is scaled down to this size
+    int ndiOutputHeight = 360;
+    int ndiOutputFps = 15;
     std::string backend = "glfw";
     int width = 1920;
     int height = 1080;
@@ -20,6 +29,8 @@ struct Configuration {
     int splashDurationSeconds = 5;  // Boot overlay duration; 0 = disabled
     int displayRotation = 0;        // Display rotation in degrees (0, 90, 180, 270)
     int targetFps = 60;             // Render loop target FPS (30 or 60)
+    int textureCacheMB = 256;       // Decoded image cache budget; current and next image are always kept
+    int imageDiskCacheMB = 256;     // Decoded images kept on the data partition; 0 = disabled
     std::string logLevel = "info"; // none, error, warn, info, debug
 
     static Configuration loadFromFile(const std::string& path = "config.json");
@@ -30,6 +41,8 @@ struct Configuration {
 
 const std::string SHADER_PATH = "shaders/";
 const std::string MEDIA_PATH = "media/";
+const std::string IMAGE_CACHE_PATH = "/data/cache/images/";
+const std::string MEDIA_INFO_PATH = "/data/cache/media-info.json";
 
 // Default display configuration
 constexpr uint32_t WIDTH = 1280;
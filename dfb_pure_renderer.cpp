@@ -1,5 +1,6 @@
 #ifdef HAVE_DIRECTFB
 #include "dfb_pure_renderer.h"
+#include "pixel_ops.h"
 #include <iostream>
 
 DirectFBPureRenderer::DirectFBPureRenderer() = default;
@@ -116,42 +117,9 @@ void DirectFBPureRenderer::render(const Texture& texture) {
         return;
     }
 
-    uint32_t* destPixels = static_cast<uint32_t*>(dest);
-    const uint32_t* srcPixels = reinterpret_cast<const uint32_t*>(texture.pixels);
-    int srcW = texture.width;
-    int srcH = texture.height;
-
-    auto swapRB = [](uint32_t rgba) -> uint32_t {
-        return (rgba & 0x000000FF) << 16 |
-               (rgba & 0x0000FF00) |
-               (rgba & 0x00FF0000) >> 16 |
-               (rgba & 0xFF000000);
-    };
-
-    for (int dy = 0; dy < outH; ++dy) {
-        for (int dx = 0; dx < outW; ++dx) {
-            int sx, sy;
-            switch (m_displayRotation) {
-                case 1: // 90° CW
-                    sx = dy;
-                    sy = outW - 1 - dx;
-                    break;
-                case 2: // 180°
-                    sx = srcW - 1 - dx;
-                    sy = srcH - 1 - dy;
-                    break;
-                case 3: // 270° CW
-                    sx = outH - 1 - dy;
-                    sy = dx;
-                    break;
-                default: // 0°
-                    sx = dx;
-                    sy = dy;
-                    break;
-            }
-            destPixels[dy * (pitch/4) + dx] = swapRB(srcPixels[sy * srcW + sx]);
-        }
-    }
+    PixelOps::swizzleRotateRGBAtoARGB(static_cast<uint32_t*>(dest), pitch,
+                                      reinterpret_cast<const uint32_t*>(texture.pixels), texture.planePitch(0),
+                                      texture.width, texture.height, m_displayRotation);
 
     m_texture->Unlock(m_texture);
 
@@ -192,19 +160,9 @@ void DirectFBPureRenderer::renderOverlay(const Texture& overlay) {
     int pitch;
     if (m_overlaySurface->Lock(m_overlaySurface, DSLF_WRITE, &dest, &pitch) != DFB_OK) return;
 
-    uint32_t* destPixels = static_cast<uint32_t*>(dest);
-    const uint32_t* srcPixels = reinterpret_cast<const uint32_t*>(overlay.pixels);
-
-    for (int y = 0; y < overlay.height; ++y) {
-        for (int x = 0; x < overlay.width; ++x) {
-            uint32_t rgba = srcPixels[y * overlay.width + x];
-            uint32_t bgra = (rgba & 0x000000FF) << 16 |
-                           (rgba & 0x0000FF00) |
-                           (rgba & 0x00FF0000) >> 16 |
-                           (rgba & 0xFF000000);
-            destPixels[y * (pitch/4) + x] = bgra;
-        }
-    }
+    PixelOps::swizzleRotateRGBAtoARGB(static_cast<uint32_t*>(dest), pitch,
+                                      reinterpret_cast<const uint32_t*>(overlay.pixels), overlay.planePitch(0),
+                                      overlay.width, overlay.height, 0);
 
     m_overlaySurface->Unlock(m_overlaySurface);
 
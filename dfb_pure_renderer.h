@@ -17,6 +17,12 @@ public:
     int getWidth() const override { return m_width; }
     int getHeight() const override { return m_height; }
     void setRotation(int degrees) override { m_displayRotation = degrees / 90; }
+    // Without fullscreen scaling images are blitted 1:1
+    void getImageTargetSize(int& width, int& height) const override {
+        bool sideways = (m_displayRotation % 2) != 0;
+        width = !m_fullscreenScaling ? 0 : sideways ? m_height : m_width;
+        height = !m_fullscreenScaling ? 0 : sideways ? m_width : m_height;
+    }
 
 private:
     IDirectFB* m_dfb = nullptr;
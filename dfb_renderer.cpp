@@ -123,8 +123,10 @@ void DirectFBRenderer::render(const Texture& texture) {
     
     glBindTexture(GL_TEXTURE_2D, m_texture);
     int uploadWidth = (texture.format == ColorFormat::UYVY) ? texture.width / 2 : texture.width;
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, texture.planePitch(0) / 4);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, uploadWidth, texture.height,
                  0, GL_RGBA, GL_UNSIGNED_BYTE, texture.pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
     glBindVertexArray(m_vao);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -19,6 +19,11 @@ public:
     int getWidth() const override { return m_width; }
     int getHeight() const override { return m_height; }
     void setRotation(int degrees) override { m_displayRotation = degrees / 90; }
+    void getImageTargetSize(int& width, int& height) const override {
+        bool sideways = (m_displayRotation % 2) != 0;
+        width = sideways ? m_height : m_width;
+        height = sideways ? m_width : m_height;
+    }
 
 private:
     bool initGL();
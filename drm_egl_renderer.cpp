@@ -1,6 +1,7 @@
 #ifdef DFB_ONLY
 #include "drm_egl_renderer.h"
 #include "texture.h"
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #include <fcntl.h>
@@ -28,6 +29,9 @@ DrmEglRenderer::~DrmEglRenderer() {
     if (m_vbo) glDeleteBuffers(1, &m_vbo);
     if (m_ebo) glDeleteBuffers(1, &m_ebo);
     if (m_texture) glDeleteTextures(1, &m_texture);
+    if (m_mosaicTextures[0]) glDeleteTextures(Mosaic::MAX_TILES, m_mosaicTextures);
+    for (auto& capture : m_outputCaptures) capture.release();
+    m_stills.release();
 
     auto display = static_cast<EGLDisplay>(m_eglDisplay);
     if (m_eglSurface) eglDestroySurface(display, static_cast<EGLSurface>(m_eglSurface));
@@ -361,6 +365,9 @@ bool DrmEglRenderer::initGl() {
 
     m_colorFormatLocation = glGetUniformLocation(m_shader, "colorFormat");
     m_rotationLocation = glGetUniformLocation(m_shader, "displayRotation");
+    m_tileFormatsLocation = glGetUniformLocation(m_shader, "tileFormats");
+    m_tileExtentsLocation = glGetUniformLocation(m_shader, "tileExtents");
+    m_mosaicGridLocation = glGetUniformLocation(m_shader, "mosaicGrid");
 
     // Setup quad buffers
     glGenVertexArrays(1, &m_vao);
@@ -392,22 +399,62 @@ bool DrmEglRenderer::initGl() {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+    // One texture per mosaic tile, on units after the single-frame planes
+    glGenTextures(Mosaic::MAX_TILES, m_mosaicTextures);
+    int mosaicUnits[Mosaic::MAX_TILES];
+    for (int i = 0; i < Mosaic::MAX_TILES; i++) {
+        glBindTexture(GL_TEXTURE_2D, m_mosaicTextures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        mosaicUnits[i] = Mosaic::FIRST_TEXTURE_UNIT + i;
+    }
+
     glUseProgram(m_shader);
     glUniform1i(glGetUniformLocation(m_shader, "screenTexture"), 0);
     glUniform1i(glGetUniformLocation(m_shader, "uvTexture"), 1);
     glUniform1i(glGetUniformLocation(m_shader, "vTexture"), 2);
+    glUniform1iv(glGetUniformLocation(m_shader, "mosaicTiles"), Mosaic::MAX_TILES, mosaicUnits);
 
     glViewport(0, 0, m_width, m_height);
     return true;
 }
 
+// Upload one Y/U/V/UV plane honouring its pitch and bit depth (16-bit for > 8)
+static void uploadPlane(const Texture& texture, int plane, int w, int h, int components) {
+    bool wide = texture.planeBitDepth(plane) > 8;
+    int bytesPerTexel = components * (wide ? 2 : 1);
+    GLenum internalFormat = (components == 1) ? (wide ? GL_R16 : GL_R8) : (wide ? GL_RG16 : GL_RG8);
+    GLenum format = (components == 1) ? GL_RED : GL_RG;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, texture.planePitch(plane) / bytesPerTexel);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, format,
+                 wide ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE, texture.planeData(plane));
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+static bool isPackedFormat(ColorFormat format) {
+    return format == ColorFormat::RGBA || format == ColorFormat::UYVY || format == ColorFormat::UYVA;
+}
+
+// Upload a single-plane RGBA/UYVY/UYVA frame (UYVY packs two pixels per RGBA texel)
+static void uploadPacked(const Texture& texture) {
+    int uploadWidth = (texture.format == ColorFormat::UYVY) ? texture.width / 2 : texture.width;
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, texture.planePitch(0) / 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, uploadWidth, texture.height,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, texture.pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
 void DrmEglRenderer::render(const Texture& texture) {
     glClear(GL_COLOR_BUFFER_BIT);
     glUseProgram(m_shader);
     glUniform1i(m_colorFormatLocation, static_cast<int>(texture.format));
     glUniform1i(m_rotationLocation, m_displayRotation);
 
-    if (texture.format == ColorFormat::DMABUF_NV12 && texture.dmaFd >= 0) {
+    if (texture.format == ColorFormat::DMABUF_NV12 && texture.planes[0].dmaFd >= 0) {
         // Zero-copy VA-API: import DMA-BUF fd as EGL images
         auto display = static_cast<EGLDisplay>(m_eglDisplay);
 
@@ -422,9 +469,9 @@ void DrmEglRenderer::render(const Texture& texture) {
                 EGL_WIDTH, texture.width,
                 EGL_HEIGHT, texture.height,
                 EGL_LINUX_DRM_FOURCC_EXT, DRM_FORMAT_R8,
-                EGL_DMA_BUF_PLANE0_FD_EXT, texture.dmaFd,
-                EGL_DMA_BUF_PLANE0_OFFSET_EXT, (EGLint)texture.dmaOffset[0],
-                EGL_DMA_BUF_PLANE0_PITCH_EXT, (EGLint)texture.dmaPitch[0],
+                EGL_DMA_BUF_PLANE0_FD_EXT, texture.planes[0].dmaFd,
+                EGL_DMA_BUF_PLANE0_OFFSET_EXT, (EGLint)texture.planes[0].offset,
+                EGL_DMA_BUF_PLANE0_PITCH_EXT, texture.planes[0].pitch,
                 EGL_NONE
             };
             EGLImageKHR yImage = eglCreateImageKHR(display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, nullptr, yAttribs);
@@ -435,14 +482,15 @@ void DrmEglRenderer::render(const Texture& texture) {
                 eglDestroyImageKHR(display, yImage);
             }
 
-            // UV plane EGL image
+            // UV plane EGL image (may be in a separate object with its own fd)
+            const TexturePlane& uv = texture.planeCount > 1 ? texture.planes[1] : texture.planes[0];
             EGLint uvAttribs[] = {
                 EGL_WIDTH, texture.width / 2,
                 EGL_HEIGHT, texture.height / 2,
                 EGL_LINUX_DRM_FOURCC_EXT, DRM_FORMAT_GR88,
-                EGL_DMA_BUF_PLANE0_FD_EXT, texture.dmaFd,
-                EGL_DMA_BUF_PLANE0_OFFSET_EXT, (EGLint)texture.dmaOffset[1],
-                EGL_DMA_BUF_PLANE0_PITCH_EXT, (EGLint)texture.dmaPitch[1],
+                EGL_DMA_BUF_PLANE0_FD_EXT, uv.dmaFd,
+                EGL_DMA_BUF_PLANE0_OFFSET_EXT, (EGLint)uv.offset,
+                EGL_DMA_BUF_PLANE0_PITCH_EXT, uv.pitch,
                 EGL_NONE
             };
             EGLImageKHR uvImage = eglCreateImageKHR(display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, nullptr, uvAttribs);
@@ -454,46 +502,86 @@ void DrmEglRenderer::render(const Texture& texture) {
             }
         }
     } else if (texture.format == ColorFormat::YUV420P) {
-        size_t ySize = (size_t)texture.width * texture.height;
-        size_t uvPlaneSize = (size_t)(texture.width / 2) * (texture.height / 2);
-
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, m_texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, texture.width, texture.height,
-                     0, GL_RED, GL_UNSIGNED_BYTE, texture.pixels);
+        uploadPlane(texture, 0, texture.width, texture.height, 1);
 
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, m_uvTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, texture.width / 2, texture.height / 2,
-                     0, GL_RED, GL_UNSIGNED_BYTE, texture.pixels + ySize);
+        uploadPlane(texture, 1, texture.width / 2, texture.height / 2, 1);
 
         glActiveTexture(GL_TEXTURE2);
         glBindTexture(GL_TEXTURE_2D, m_vTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, texture.width / 2, texture.height / 2,
-                     0, GL_RED, GL_UNSIGNED_BYTE, texture.pixels + ySize + uvPlaneSize);
+        uploadPlane(texture, 2, texture.width / 2, texture.height / 2, 1);
+        glActiveTexture(GL_TEXTURE0);
     } else if (texture.format == ColorFormat::NV12) {
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, m_texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, texture.width, texture.height,
-                     0, GL_RED, GL_UNSIGNED_BYTE, texture.pixels);
+        uploadPlane(texture, 0, texture.width, texture.height, 1);
 
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, m_uvTexture);
-        const unsigned char* uvData = texture.pixels + (texture.width * texture.height);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG, texture.width / 2, texture.height / 2,
-                     0, GL_RG, GL_UNSIGNED_BYTE, uvData);
+        uploadPlane(texture, 1, texture.width / 2, texture.height / 2, 2);
+        glActiveTexture(GL_TEXTURE0);
     } else {
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, m_texture);
-        int uploadWidth = (texture.format == ColorFormat::UYVY) ? texture.width / 2 : texture.width;
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, uploadWidth, texture.height,
-                     0, GL_RGBA, GL_UNSIGNED_BYTE, texture.pixels);
+        uploadPacked(texture);
     }
 
     glBindVertexArray(m_vao);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 }
 
+void DrmEglRenderer::renderStill(const std::string& name, uint64_t version, const Texture& texture) {
+    glActiveTexture(GL_TEXTURE0);
+    if (!m_stills.bind(name, version, texture)) {
+        render(texture);
+        return;
+    }
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(m_shader);
+    glUniform1i(m_colorFormatLocation, static_cast<int>(texture.format));
+    glUniform1i(m_rotationLocation, m_displayRotation);
+    glBindVertexArray(m_vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
+
+void DrmEglRenderer::renderMosaic(const std::vector<Texture>& tiles, int columns, int rows) {
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(m_shader);
+    glUniform1i(m_colorFormatLocation, Mosaic::SHADER_FORMAT);
+    glUniform1i(m_rotationLocation, m_displayRotation);
+    glUniform2i(m_mosaicGridLocation, columns, rows);
+
+    // Cells in content orientation; the vertex shader rotates the whole grid
+    bool sideways = (m_displayRotation % 2) != 0;
+    float cellWidth = static_cast<float>(sideways ? m_height : m_width) / columns;
+    float cellHeight = static_cast<float>(sideways ? m_width : m_height) / rows;
+
+    int formats[Mosaic::MAX_TILES];
+    float extents[Mosaic::MAX_TILES * 2];
+    int count = std::min({static_cast<int>(tiles.size()), columns * rows, Mosaic::MAX_TILES});
+    for (int i = 0; i < Mosaic::MAX_TILES; i++) {
+        formats[i] = -1;
+        extents[i * 2] = extents[i * 2 + 1] = 1.0f;
+        if (i >= count || !tiles[i].isValid() || !isPackedFormat(tiles[i].format)) continue;
+
+        glActiveTexture(GL_TEXTURE0 + Mosaic::FIRST_TEXTURE_UNIT + i);
+        glBindTexture(GL_TEXTURE_2D, m_mosaicTextures[i]);
+        uploadPacked(tiles[i]);
+        formats[i] = static_cast<int>(tiles[i].format);
+        Mosaic::fitExtent(tiles[i].width, tiles[i].height, cellWidth, cellHeight,
+                          extents[i * 2], extents[i * 2 + 1]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1iv(m_tileFormatsLocation, Mosaic::MAX_TILES, formats);
+    glUniform2fv(m_tileExtentsLocation, Mosaic::MAX_TILES, extents);
+
+    glBindVertexArray(m_vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
+
 void DrmEglRenderer::renderOverlay(const Texture& overlay) {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -511,6 +599,12 @@ void DrmEglRenderer::renderOverlay(const Texture& overlay) {
     glDisable(GL_BLEND);
 }
 
+void DrmEglRenderer::requestOutputCapture(int channel, int width, int height) {
+    if (channel < 0 || channel >= OUTPUT_CHANNELS) return;
+    m_outputCaptureWidth[channel] = width;
+    m_outputCaptureHeight[channel] = height;
+}
+
 void DrmEglRenderer::present() {
     auto display = static_cast<EGLDisplay>(m_eglDisplay);
     auto surface = static_cast<EGLSurface>(m_eglSurface);
@@ -527,7 +621,17 @@ void DrmEglRenderer::present() {
         m_flipPending = false;
     }
 
+    for (int channel = 0; channel < OUTPUT_CHANNELS; channel++) {
+        if (m_outputSink && m_outputCaptureWidth[channel] > 0) {
+            m_outputCaptures[channel].capture(m_width, m_height, m_outputCaptureWidth[channel],
+                                              m_outputCaptureHeight[channel]);
+        }
+        m_outputCaptureWidth[channel] = 0;
+        m_outputCaptureHeight[channel] = 0;
+    }
     eglSwapBuffers(display, surface);
+    for (int channel = 0; channel < OUTPUT_CHANNELS; channel++)
+        m_outputCaptures[channel].collect(channel, m_outputSink);
 
     gbm_bo* bo = gbm_surface_lock_front_buffer(m_gbmSurface);
     if (!bo) return;
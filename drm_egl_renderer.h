@@ -3,6 +3,9 @@
 
 #include "irenderer.h"
 #include "loader.h"
+#include "mosaic_layout.h"
+#include "gl_output_capture.h"
+#include "gl_still_cache.h"
 #include <cstdint>
 
 struct gbm_device;
@@ -18,12 +21,23 @@ public:
               bool fullscreen = true, int monitorIndex = 0) override;
     void processInput() override {}
     void render(const Texture& texture) override;
+    void renderStill(const std::string& name, uint64_t version, const Texture& texture) override;
     void renderOverlay(const Texture& overlay) override;
+    void renderMosaic(const std::vector<Texture>& tiles, int columns, int rows) override;
     void present() override;
     bool shouldClose() const override { return false; }
     int getWidth() const override { return m_width; }
     int getHeight() const override { return m_height; }
     void setRotation(int degrees) override { m_displayRotation = degrees / 90; }
+    void getImageTargetSize(int& width, int& height) const override {
+        bool sideways = (m_displayRotation % 2) != 0;
+        width = sideways ? m_height : m_width;
+        height = sideways ? m_width : m_height;
+    }
+    bool supportsPlanarYUV() const override { return true; }
+    bool supportsOutputCapture() const override { return true; }
+    void setOutputSink(OutputSink sink) override { m_outputSink = std::move(sink); }
+    void requestOutputCapture(int channel, int width, int height) override;
 
 private:
     bool initDrm();
@@ -57,9 +71,18 @@ private:
     unsigned int m_texture = 0;
     unsigned int m_uvTexture = 0;
     unsigned int m_vTexture = 0;
+    unsigned int m_mosaicTextures[Mosaic::MAX_TILES] = {};
     int m_colorFormatLocation = -1;
     int m_rotationLocation = -1;
+    int m_tileFormatsLocation = -1;
+    int m_tileExtentsLocation = -1;
+    int m_mosaicGridLocation = -1;
     int m_displayRotation = 0;
+    GLOutputCapture m_outputCaptures[OUTPUT_CHANNELS];
+    GLStillCache m_stills;
+    OutputSink m_outputSink;
+    int m_outputCaptureWidth[OUTPUT_CHANNELS] = {};    // requested for the frame being composited
+    int m_outputCaptureHeight[OUTPUT_CHANNELS] = {};
 
     Loader m_loader;
     int m_width = 0;
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <sys/stat.h>
+
+// Modification time of a stat() result in nanoseconds since the epoch.
+// Linux names the timespec st_mtim, Apple platforms st_mtimespec.
+inline int64_t statMtimeNs(const struct stat& st) {
+#ifdef __APPLE__
+    return static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Work that must happen between two rendered frames, so several state changes
+// become visible together. Any thread may post(); the render loop calls
+// runPending() at the top of each iteration, before it picks up state.
+class FrameBoundary {
+public:
+    using Task = std::function<void()>;
+
+    void post(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_closed) {
+                m_tasks.push_back(std::move(task));
+                return;
+            }
+        }
+        task();   // render loop has exited; nothing left to tear
+    }
+
+    void runPending() {
+        std::vector<Task> tasks;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_tasks.empty()) return;
+            tasks.swap(m_tasks);
+        }
+        for (auto& task : tasks) task();
+    }
+
+    // Call once the render loop has stopped: runs what is queued and makes
+    // later post() calls run inline, so no poster waits forever
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        runPending();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<Task> m_tasks;
+    bool m_closed = false;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Recycles fixed-size frame buffers between the decoder and the render loop.
+// A buffer handed out by acquire() returns to the pool when the last Texture
+// referencing it is destroyed, so steady-state playback allocates nothing.
+class FramePool {
+public:
+    using Buffer = std::vector<unsigned char>;
+
+    explicit FramePool(size_t maxFree = 8) : m_state(std::make_shared<State>()) {
+        m_state->maxFree = maxFree;
+    }
+
+    // Returns a buffer of exactly `size` bytes (contents undefined)
+    std::shared_ptr<Buffer> acquire(size_t size) {
+        Buffer* buf = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            auto& free = m_state->free;
+            for (size_t i = 0; i < free.size(); i++) {
+                if (free[i]->size() == size) {
+                    buf = free[i].release();
+                    free.erase(free.begin() + i);
+                    break;
+                }
+            }
+        }
+        if (!buf)
+            buf = new Buffer(size);
+
+        // The deleter holds the pool state, so buffers may outlive the pool
+        std::shared_ptr<State> state = m_state;
+        return std::shared_ptr<Buffer>(buf, [state](Buffer* b) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->free.size() < state->maxFree)
+                state->free.emplace_back(b);
+            else
+                delete b;
+        });
+    }
+
+    // Drop all idle buffers (e.g. after a resolution change)
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->free.clear();
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Buffer>> free;
+        size_t maxFree = 8;
+    };
+    std::shared_ptr<State> m_state;
+};
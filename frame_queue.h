@@ -0,0 +1,206 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <array>
+#include <condition_variable>
+#include "log.h"
+#include "texture.h"
+
+// Thread-safe ring buffer for decoded frames with PTS timestamps.
+// Dropped frames release their buffers (and DMA-BUF fds) via Texture::sharedStorage.
+class FrameQueue {
+public:
+    static constexpr int CAPACITY = 180; // ~3s at 60fps - covers HLS segment gaps
+
+    struct Entry {
+        double pts = 0.0;
+        Texture frame;
+        bool valid = false;
+    };
+
+    // Push a frame. If blocking=true, waits when full (for file playback).
+    // If blocking=false, drops oldest when full (for live streams).
+    void push(double pts, Texture&& frame, bool blocking = false) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (blocking && m_count >= CAPACITY) {
+            LOG_DEBUG("Queue BLOCKING (count=" << m_count << ")");
+            m_notFull.wait(lock, [this] { return m_count < CAPACITY || m_stopped; });
+            if (m_stopped) return;
+        } else if (!blocking && m_count >= CAPACITY) {
+            int oldestIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
+            auto& old = m_buffer[oldestIdx];
+            old.frame = Texture();
+            old.valid = false;
+            m_count--;
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        auto& slot = m_buffer[m_writeIdx];
+        slot.pts = pts;
+        slot.frame = std::move(frame);
+        slot.valid = true;
+        m_writeIdx = (m_writeIdx + 1) % CAPACITY;
+        if (m_count < CAPACITY) m_count++;
+        m_depth.store(m_count, std::memory_order_relaxed);
+        uint64_t pushed = m_totalPushed.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (pushed <= 10 || pushed % 1000 == 0)
+            LOG_DEBUG("Queue push #" << pushed << " pts=" << pts << " count=" << m_count << " blocking=" << blocking);
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+        m_notFull.notify_all();
+    }
+
+    // Discard every queued frame (after a seek)
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int dropped = 0;
+        while (m_count > 0) {
+            int oldestIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
+            m_buffer[oldestIdx].frame = Texture();
+            m_buffer[oldestIdx].valid = false;
+            m_count--;
+            dropped++;
+        }
+        m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+        m_depth.store(0, std::memory_order_relaxed);
+        m_notFull.notify_all();
+    }
+
+    // Get the frame with PTS closest to but not after `time`.
+    // Drops older frames. Returns false if no frame available.
+    bool getFrameForTime(double time, Texture& out) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_count == 0) return false;
+
+        // Find the best frame: the one with PTS closest to but not after `time`
+        int bestIdx = -1;
+        double bestPts = -1e30;
+        int startIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
+
+        for (int i = 0; i < m_count; i++) {
+            int idx = (startIdx + i) % CAPACITY;
+            if (m_buffer[idx].valid && m_buffer[idx].pts <= time + 0.001 && m_buffer[idx].pts > bestPts) {
+                bestIdx = idx;
+                bestPts = m_buffer[idx].pts;
+            }
+        }
+
+        if (bestIdx < 0) return false;  // all frames in the future
+
+        out = m_buffer[bestIdx].frame;
+
+        // Drop all frames up to and including the one we picked
+        int dropped = 0;
+        while (m_count > 0) {
+            int oldestIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
+            auto& old = m_buffer[oldestIdx];
+            old.frame = Texture();
+            old.valid = false;
+            m_count--;
+            dropped++;
+            if (oldestIdx == bestIdx) break;
+        }
+        // Everything before the picked frame was never shown
+        m_dropped.fetch_add(dropped - 1, std::memory_order_relaxed);
+        m_depth.store(m_count, std::memory_order_relaxed);
+
+        if (dropped > 0) m_notFull.notify_one();
+        return true;
+    }
+
+    // Consume the next frame in order (for file playback with blocking queue)
+    bool getNext(Texture& out, double* outPts = nullptr) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_count == 0) return false;
+
+        int oldestIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
+        if (outPts) *outPts = m_buffer[oldestIdx].pts;
+        out = std::move(m_buffer[oldestIdx].frame);
+        m_buffer[oldestIdx].valid = false;
+        m_count--;
+        m_depth.store(m_count, std::memory_order_relaxed);
+        m_notFull.notify_one();
+        return true;
+    }
+
+    // Get the most recent frame (for live streams - always latest, drop rest)
+    bool getLatest(Texture& out) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_count == 0) return false;
+
+        int newestIdx = (m_writeIdx - 1 + CAPACITY) % CAPACITY;
+        out = m_buffer[newestIdx].frame;
+
+        int dropped = 0;
+        while (m_count > 1) {
+            int oldestIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
+            auto& old = m_buffer[oldestIdx];
+            old.frame = Texture();
+            old.valid = false;
+            m_count--;
+            dropped++;
+        }
+        m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+        m_depth.store(m_count, std::memory_order_relaxed);
+
+        if (dropped > 0)
+            m_notFull.notify_one();
+
+        return true;
+    }
+
+    bool full() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_count >= CAPACITY;
+    }
+
+    // Block until there's space in the queue (for throttling the decoder)
+    void waitForSpace(std::atomic<bool>& running) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this, &running] { return m_count < CAPACITY / 2 || m_stopped || !running; });
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_count == 0;
+    }
+
+    int size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_count;
+    }
+
+    // Lock-free counters for metrics; may lag the queue by one operation
+    int depth() const { return m_depth.load(std::memory_order_relaxed); }
+    uint64_t totalPushed() const { return m_totalPushed.load(std::memory_order_relaxed); }
+    uint64_t droppedFrames() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    double oldestPts() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_count == 0) return -1.0;
+        int idx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
+        return m_buffer[idx].pts;
+    }
+
+    double newestPts() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_count == 0) return 0.0;
+        int idx = (m_writeIdx - 1 + CAPACITY) % CAPACITY;
+        return m_buffer[idx].pts;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::array<Entry, CAPACITY> m_buffer;
+    int m_writeIdx = 0;
+    int m_count = 0;
+    bool m_stopped = false;
+    std::atomic<int> m_depth{0};
+    std::atomic<uint64_t> m_totalPushed{0};
+    std::atomic<uint64_t> m_dropped{0};   // frames discarded without being shown
+};
@@ -0,0 +1,95 @@
+#include "gl_output_capture.h"
+#include <glad/gl.h>
+#include <iostream>
+
+bool GLOutputCapture::resize(int width, int height) {
+    release();
+
+    glGenTextures(1, &m_colorTexture);
+    glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cerr << "Output capture: framebuffer incomplete at " << width << "x" << height << std::endl;
+        release();
+        return false;
+    }
+
+    for (auto& slot : m_slots) {
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+void GLOutputCapture::capture(int sourceWidth, int sourceHeight, int width, int height) {
+    if (width <= 0 || height <= 0) return;
+    if ((width != m_width || height != m_height) && !resize(width, height)) return;
+    if (m_pending == SLOTS) return;   // reader is behind; drop rather than stall
+
+    // Downscale and flip in one blit so rows come back top row first
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbo);
+    glBlitFramebuffer(0, 0, sourceWidth, sourceHeight, 0, m_height, m_width, 0,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    Slot& slot = m_slots[m_head];
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_head = (m_head + 1) % SLOTS;
+    m_pending++;
+}
+
+void GLOutputCapture::collect(int channel, const IRenderer::OutputSink& sink) {
+    while (m_pending > 0) {
+        Slot& slot = m_slots[(m_head - m_pending + SLOTS) % SLOTS];
+        auto fence = static_cast<GLsync>(slot.fence);
+        GLenum state = glClientWaitSync(fence, 0, 0);
+        if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED) return;
+        glDeleteSync(fence);
+        slot.fence = nullptr;
+        m_pending--;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                              static_cast<GLsizeiptr>(m_width) * m_height * 4, GL_MAP_READ_BIT);
+        if (pixels && sink) {
+            sink(channel, static_cast<const uint8_t*>(pixels), m_width, m_height, m_width * 4);
+        }
+        if (pixels) glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+void GLOutputCapture::release() {
+    for (auto& slot : m_slots) {
+        if (slot.fence) glDeleteSync(static_cast<GLsync>(slot.fence));
+        if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+        slot = Slot();
+    }
+    if (m_fbo) glDeleteFramebuffers(1, &m_fbo);
+    if (m_colorTexture) glDeleteTextures(1, &m_colorTexture);
+    m_fbo = 0;
+    m_colorTexture = 0;
+    m_head = 0;
+    m_pending = 0;
+    m_width = 0;
+    m_height = 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "irenderer.h"
+
+// Asynchronous readback of the composited frame for program-feed outputs.
+// capture() downscales the back buffer into a small framebuffer and starts a
+// glReadPixels into a pixel-buffer object guarded by a fence; collect() maps
+// the readbacks whose fence has signalled, typically one or two frames later.
+// Neither call waits on the GPU: when every buffer is still in flight the
+// capture is skipped.
+class GLOutputCapture {
+public:
+    ~GLOutputCapture() = default;   // release() must run while the context is current
+
+    // Call before swapping buffers. sourceWidth/Height is the drawable size.
+    void capture(int sourceWidth, int sourceHeight, int width, int height);
+
+    // Hand finished readbacks (RGBA, top row first) to `sink`, oldest first
+    void collect(int channel, const IRenderer::OutputSink& sink);
+
+    void release();
+
+private:
+    static constexpr int SLOTS = 3;
+
+    struct Slot {
+        unsigned int pbo = 0;
+        void* fence = nullptr;   // GLsync, kept opaque so the header stays GL-free
+    };
+
+    bool resize(int width, int height);
+
+    Slot m_slots[SLOTS];
+    int m_head = 0;      // next slot to capture into
+    int m_pending = 0;   // captures in flight, oldest at m_head - m_pending
+    unsigned int m_fbo = 0;
+    unsigned int m_colorTexture = 0;
+    int m_width = 0;
+    int m_height = 0;
+};
@@ -0,0 +1,61 @@
+#include "gl_still_cache.h"
+#include <glad/gl.h>
+
+bool GLStillCache::bind(const std::string& name, uint64_t version, const Texture& texture) {
+    if (texture.format != ColorFormat::RGBA || !texture.pixels) return false;
+
+    auto it = m_entries.find(name);
+    if (it != m_entries.end() && it->second.version == version) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+        glBindTexture(GL_TEXTURE_2D, it->second.texture);
+        return true;
+    }
+    if (it != m_entries.end()) remove(it);
+
+    // Base level plus a third for the mipmap chain
+    size_t bytes = static_cast<size_t>(texture.width) * texture.height * 4 * 4 / 3;
+    evictToFit(bytes);
+
+    Entry& entry = m_entries[name];
+    entry.texture = upload(texture);   // leaves it bound
+    entry.version = version;
+    entry.bytes = bytes;
+    m_lru.push_front(name);
+    entry.lruPosition = m_lru.begin();
+    m_bytes += bytes;
+    return true;
+}
+
+unsigned int GLStillCache::upload(const Texture& texture) {
+    unsigned int id = 0;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, texture.planePitch(0) / 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture.width, texture.height,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, texture.pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    return id;
+}
+
+void GLStillCache::remove(std::map<std::string, Entry>::iterator it) {
+    glDeleteTextures(1, &it->second.texture);
+    m_bytes -= it->second.bytes;
+    m_lru.erase(it->second.lruPosition);
+    m_entries.erase(it);
+}
+
+void GLStillCache::evictToFit(size_t incoming) {
+    while (!m_lru.empty() && m_bytes + incoming > BUDGET_BYTES) {
+        remove(m_entries.find(m_lru.back()));
+    }
+}
+
+void GLStillCache::release() {
+    while (!m_entries.empty()) remove(m_entries.begin());
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "texture.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+
+// Recently shown still images kept as GL textures, so showing one again, or
+// redrawing it every frame, does not upload it again. Textures are keyed by
+// image name and carry the version they were uploaded from; a new version of
+// a name replaces the old texture. Each has a full mipmap chain, so images
+// larger than the display are minified without shimmering.
+//
+// Video memory is capped; the least recently shown textures are deleted
+// first. The texture being bound always stays, even if it alone exceeds it.
+class GLStillCache {
+public:
+    static constexpr size_t BUDGET_BYTES = 96u * 1024 * 1024;
+
+    ~GLStillCache() = default;   // release() must run while the context is current
+
+    // Bind the texture for `name` at `version` on the active texture unit,
+    // uploading `texture` first if it is not resident. False, leaving the
+    // binding untouched, for anything but packed RGBA.
+    bool bind(const std::string& name, uint64_t version, const Texture& texture);
+
+    void release();
+
+private:
+    struct Entry {
+        unsigned int texture = 0;
+        uint64_t version = 0;
+        size_t bytes = 0;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    unsigned int upload(const Texture& texture);
+    void remove(std::map<std::string, Entry>::iterator it);
+    void evictToFit(size_t incoming);
+
+    std::map<std::string, Entry> m_entries;
+    std::list<std::string> m_lru;   // most recently shown first
+    size_t m_bytes = 0;
+};
@@ -1,4 +1,5 @@
 #include "glfw_renderer.h"
+#include <algorithm>
 #include <iostream>
 
 static void glfwErrorCallback(int error, const char* description) {
@@ -13,6 +14,9 @@ GLFWRenderer::~GLFWRenderer() {
     glDeleteBuffers(1, &EBO);
     glDeleteProgram(shaderProgram);
     glDeleteTextures(1, &texture);
+    glDeleteTextures(Mosaic::MAX_TILES, m_mosaicTextures);
+    for (auto& capture : m_outputCaptures) capture.release();
+    m_stills.release();
     glfwTerminate();
 }
 
@@ -87,14 +91,54 @@ bool GLFWRenderer::init(int width, int height, const char* title, bool fullscree
 
     glActiveTexture(GL_TEXTURE0);
 
+    // One texture per mosaic tile, on units after the single-frame planes
+    glGenTextures(Mosaic::MAX_TILES, m_mosaicTextures);
+    int mosaicUnits[Mosaic::MAX_TILES];
+    for (int i = 0; i < Mosaic::MAX_TILES; i++) {
+        glBindTexture(GL_TEXTURE_2D, m_mosaicTextures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        mosaicUnits[i] = Mosaic::FIRST_TEXTURE_UNIT + i;
+    }
+
     glUseProgram(shaderProgram);
     glUniform1i(glGetUniformLocation(shaderProgram, "screenTexture"), 0);
     glUniform1i(glGetUniformLocation(shaderProgram, "uvTexture"), 1);
     glUniform1i(glGetUniformLocation(shaderProgram, "vTexture"), 2);
+    glUniform1iv(glGetUniformLocation(shaderProgram, "mosaicTiles"), Mosaic::MAX_TILES, mosaicUnits);
 
     return true;
 }
 
+// Upload one Y/U/V/UV plane honouring its pitch and bit depth (16-bit for > 8)
+static void uploadPlane(const Texture& texture, int plane, int w, int h, int components) {
+    bool wide = texture.planeBitDepth(plane) > 8;
+    int bytesPerTexel = components * (wide ? 2 : 1);
+    GLenum internalFormat = (components == 1) ? (wide ? GL_R16 : GL_R8) : (wide ? GL_RG16 : GL_RG8);
+    GLenum format = (components == 1) ? GL_RED : GL_RG;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, texture.planePitch(plane) / bytesPerTexel);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, format,
+                 wide ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE, texture.planeData(plane));
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+static bool isPackedFormat(ColorFormat format) {
+    return format == ColorFormat::RGBA || format == ColorFormat::UYVY || format == ColorFormat::UYVA;
+}
+
+// Upload a single-plane RGBA/UYVY/UYVA frame (UYVY packs two pixels per RGBA texel)
+static void uploadPacked(const Texture& texture) {
+    int uploadWidth = (texture.format == ColorFormat::UYVY) ? texture.width / 2 : texture.width;
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, texture.planePitch(0) / 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, uploadWidth, texture.height,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, texture.pixels);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
 void GLFWRenderer::render(const Texture& texture) {
     glClear(GL_COLOR_BUFFER_BIT);
     glUseProgram(shaderProgram);
@@ -103,29 +147,85 @@ void GLFWRenderer::render(const Texture& texture) {
 
     if (texture.format == ColorFormat::NV12) {
         // NV12: Y plane (full res, single channel) + UV interleaved (half res, two channels)
-        size_t ySize = (size_t)texture.width * texture.height;
-
         glUniform1i(glGetUniformLocation(shaderProgram, "screenTexture"), 0);
         glUniform1i(glGetUniformLocation(shaderProgram, "uvTexture"), 1);
 
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, this->texture);
+        uploadPlane(texture, 0, texture.width, texture.height, 1);
 
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, m_uvTexture);
+        uploadPlane(texture, 1, texture.width / 2, texture.height / 2, 2);
+        glActiveTexture(GL_TEXTURE0);
+    } else if (texture.format == ColorFormat::YUV420P) {
+        // YUV420P: Y (full res) + U + V (half res), one channel each
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, this->texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, texture.width, texture.height,
-                     0, GL_RED, GL_UNSIGNED_BYTE, texture.pixels);
+        uploadPlane(texture, 0, texture.width, texture.height, 1);
 
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, m_uvTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, texture.width / 2, texture.height / 2,
-                     0, GL_RG, GL_UNSIGNED_BYTE, texture.pixels + ySize);
+        uploadPlane(texture, 1, texture.width / 2, texture.height / 2, 1);
+
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, m_vTexture);
+        uploadPlane(texture, 2, texture.width / 2, texture.height / 2, 1);
+        glActiveTexture(GL_TEXTURE0);
     } else {
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, this->texture);
-        int uploadWidth = (texture.format == ColorFormat::UYVY) ? texture.width / 2 : texture.width;
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, uploadWidth, texture.height,
-                     0, GL_RGBA, GL_UNSIGNED_BYTE, texture.pixels);
+        uploadPacked(texture);
+    }
+
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
+
+void GLFWRenderer::renderStill(const std::string& name, uint64_t version, const Texture& texture) {
+    glActiveTexture(GL_TEXTURE0);
+    if (!m_stills.bind(name, version, texture)) {
+        render(texture);
+        return;
+    }
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(shaderProgram);
+    glUniform1i(colorFormatLocation, static_cast<int>(texture.format));
+    glUniform1i(rotationLocation, m_displayRotation);
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
+
+void GLFWRenderer::renderMosaic(const std::vector<Texture>& tiles, int columns, int rows) {
+    glClear(GL_COLOR_BUFFER_BIT);
+    glUseProgram(shaderProgram);
+    glUniform1i(colorFormatLocation, Mosaic::SHADER_FORMAT);
+    glUniform1i(rotationLocation, m_displayRotation);
+    glUniform2i(m_mosaicGridLocation, columns, rows);
+
+    // Cells in content orientation; the vertex shader rotates the whole grid
+    bool sideways = (m_displayRotation % 2) != 0;
+    float cellWidth = static_cast<float>(sideways ? m_height : m_width) / columns;
+    float cellHeight = static_cast<float>(sideways ? m_width : m_height) / rows;
+
+    int formats[Mosaic::MAX_TILES];
+    float extents[Mosaic::MAX_TILES * 2];
+    int count = std::min({static_cast<int>(tiles.size()), columns * rows, Mosaic::MAX_TILES});
+    for (int i = 0; i < Mosaic::MAX_TILES; i++) {
+        formats[i] = -1;
+        extents[i * 2] = extents[i * 2 + 1] = 1.0f;
+        if (i >= count || !tiles[i].isValid() || !isPackedFormat(tiles[i].format)) continue;
+
+        glActiveTexture(GL_TEXTURE0 + Mosaic::FIRST_TEXTURE_UNIT + i);
+        glBindTexture(GL_TEXTURE_2D, m_mosaicTextures[i]);
+        uploadPacked(tiles[i]);
+        formats[i] = static_cast<int>(tiles[i].format);
+        Mosaic::fitExtent(tiles[i].width, tiles[i].height, cellWidth, cellHeight,
+                          extents[i * 2], extents[i * 2 + 1]);
     }
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1iv(m_tileFormatsLocation, Mosaic::MAX_TILES, formats);
+    glUniform2fv(m_tileExtentsLocation, Mosaic::MAX_TILES, extents);
 
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -149,8 +249,27 @@ void GLFWRenderer::renderOverlay(const Texture& overlay) {
     glDisable(GL_BLEND);
 }
 
+void GLFWRenderer::requestOutputCapture(int channel, int width, int height) {
+    if (channel < 0 || channel >= OUTPUT_CHANNELS) return;
+    m_outputCaptureWidth[channel] = width;
+    m_outputCaptureHeight[channel] = height;
+}
+
 void GLFWRenderer::present() {
+    int fbWidth = 0;
+    int fbHeight = 0;
+    glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+    for (int channel = 0; channel < OUTPUT_CHANNELS; channel++) {
+        if (m_outputSink && m_outputCaptureWidth[channel] > 0) {
+            m_outputCaptures[channel].capture(fbWidth, fbHeight, m_outputCaptureWidth[channel],
+                                              m_outputCaptureHeight[channel]);
+        }
+        m_outputCaptureWidth[channel] = 0;
+        m_outputCaptureHeight[channel] = 0;
+    }
     glfwSwapBuffers(window);
+    for (int channel = 0; channel < OUTPUT_CHANNELS; channel++)
+        m_outputCaptures[channel].collect(channel, m_outputSink);
     glfwPollEvents();
 }
 
@@ -263,6 +382,9 @@ bool GLFWRenderer::createShaders() {
     // Get uniform location
     colorFormatLocation = glGetUniformLocation(shaderProgram, "colorFormat");
     rotationLocation = glGetUniformLocation(shaderProgram, "displayRotation");
+    m_tileFormatsLocation = glGetUniformLocation(shaderProgram, "tileFormats");
+    m_tileExtentsLocation = glGetUniformLocation(shaderProgram, "tileExtents");
+    m_mosaicGridLocation = glGetUniformLocation(shaderProgram, "mosaicGrid");
 
     return true;
 }
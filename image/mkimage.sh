@@ -229,7 +229,7 @@ esac
 
 # --- Prepare data directory ---
 DATADIR="$WORK/data"
-mkdir -p "$DATADIR/media" "$DATADIR/logs" "$DATADIR/ssh" "$DATADIR/lib"
+mkdir -p "$DATADIR/media" "$DATADIR/logs" "$DATADIR/ssh" "$DATADIR/lib" "$DATADIR/cache/images"
 cp "$ROOTFS/rendermatic/config.json.default" "$DATADIR/config.json" 2>/dev/null || true
 cp "$ROOTFS/rendermatic/media/"* "$DATADIR/media/" 2>/dev/null || true
 touch "$DATADIR/.initialized"
@@ -18,6 +18,9 @@ if [ ! -f /data/.initialized ]; then
     touch /data/.initialized
 fi
 
+# Decoded image cache (also created by the app; here so it is owned by render)
+mkdir -p /data/cache/images
+
 # --- SSH key provisioning from boot partition ---
 keys_changed=false
 
@@ -0,0 +1,248 @@
+#include "image_disk_cache.h"
+#include "file_stat.h"
+#include "loader.h"
+#include "picosha2.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr char ENTRY_MAGIC[8] = { 'R', 'M', 'I', 'M', 'G', 0, 0, 1 };
+    constexpr const char* ENTRY_EXTENSION = ".rgba";
+
+    // Pixels start 64 bytes into the file, so mapped rows stay well aligned
+    struct EntryHeader {
+        char magic[8];
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;   // of the source file; pixels are always RGBA
+        uint32_t pitch;
+        uint8_t reserved[40];
+    };
+    static_assert(sizeof(EntryHeader) == 64, "entry header must stay 64 bytes");
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(fd, p, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+}
+
+bool ImageDiskCache::open(const std::string& directory, size_t maxBytes) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec || ::access(directory.c_str(), W_OK) != 0) {
+        std::cerr << "Image disk cache disabled: cannot write to " << directory << std::endl;
+        return false;
+    }
+
+    // Oldest first, so pushing each to the front leaves the newest there
+    std::vector<std::pair<fs::file_time_type, fs::directory_entry>> found;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        if (!entry.is_regular_file(ec)) continue;
+        if (entry.path().extension() != ENTRY_EXTENSION) {
+            // Leftover of a write interrupted by a crash or power cut
+            fs::remove(entry.path(), ec);
+            continue;
+        }
+        found.emplace_back(entry.last_write_time(ec), entry);
+    }
+    std::sort(found.begin(), found.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_directory = directory;
+    if (!m_directory.empty() && m_directory.back() != '/') m_directory += '/';
+    m_maxBytes = maxBytes;
+    m_entries.clear();
+    m_lru.clear();
+    m_bytes = 0;
+    for (const auto& [time, entry] : found) {
+        add(entry.path().filename().string(), static_cast<size_t>(entry.file_size(ec)));
+    }
+    evictToFit(0);
+    m_open = true;
+
+    std::cout << "Image disk cache: " << m_entries.size() << " entries, "
+              << m_bytes / (1024 * 1024) << " of " << m_maxBytes / (1024 * 1024) << " MB in "
+              << m_directory << std::endl;
+    return true;
+}
+
+bool ImageDiskCache::isOpen() const {
+    return m_open;
+}
+
+bool ImageDiskCache::entryName(const std::string& sourcePath, int targetWidth, int targetHeight, std::string& name) {
+    struct stat source;
+    if (::stat(sourcePath.c_str(), &source) != 0) return false;
+    int64_t mtimeNs = statMtimeNs(source);
+    std::string key = sourcePath + "\n" +
+                      std::to_string(mtimeNs / 1000000000) + "." + std::to_string(mtimeNs % 1000000000) + "\n" +
+                      std::to_string(source.st_size) + "\n" +
+                      std::to_string(targetWidth) + "x" + std::to_string(targetHeight);
+    name = picosha2::hash256_hex_string(key).substr(0, 32) + ENTRY_EXTENSION;
+    return true;
+}
+
+bool ImageDiskCache::mapEntry(const std::string& path, Texture& texture) {
+    size_t size = 0;
+    std::shared_ptr<void> mapping = Loader::MapFile(path, size);
+    if (!mapping || size < sizeof(EntryHeader)) return false;
+    unsigned char* base = static_cast<unsigned char*>(mapping.get());
+
+    EntryHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0 ||
+        header.width == 0 || header.height == 0 || header.pitch != header.width * 4 ||
+        size != sizeof(EntryHeader) + static_cast<size_t>(header.pitch) * header.height) {
+        return false;
+    }
+    // The texture is uploaded right away; start reading it in
+    ::madvise(base, size, MADV_WILLNEED);
+
+    texture.setSharedPixels(std::move(mapping), base + sizeof(EntryHeader),
+                            static_cast<int>(header.width), static_cast<int>(header.height),
+                            static_cast<int>(header.channels), ColorFormat::RGBA);
+    return true;
+}
+
+bool ImageDiskCache::load(const std::string& sourcePath, int targetWidth, int targetHeight, Texture& texture) {
+    if (!m_open) return false;
+    std::string name;
+    if (!entryName(sourcePath, targetWidth, targetHeight, name)) return false;
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(name);
+        if (it == m_entries.end()) {
+            m_misses++;
+            return false;
+        }
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+        path = m_directory + name;
+    }
+
+    if (!mapEntry(path, texture)) {
+        std::cerr << "Image disk cache: dropping unreadable entry " << name << std::endl;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(name);
+        if (it != m_entries.end()) remove(it);
+        m_misses++;
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    m_hits++;
+    return true;
+}
+
+bool ImageDiskCache::store(const std::string& sourcePath, int targetWidth, int targetHeight, Texture& texture) {
+    if (!m_open || !texture.pixels || texture.format != ColorFormat::RGBA) return false;
+    std::string name;
+    if (!entryName(sourcePath, targetWidth, targetHeight, name)) return false;
+
+    EntryHeader header = {};
+    std::memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+    header.width = static_cast<uint32_t>(texture.width);
+    header.height = static_cast<uint32_t>(texture.height);
+    header.channels = static_cast<uint32_t>(texture.channels);
+    header.pitch = header.width * 4;
+    size_t bytes = sizeof(EntryHeader) + static_cast<size_t>(header.pitch) * header.height;
+
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Anything bigger than a quarter of the cache would just churn it
+        if (bytes > m_maxBytes / 4) return false;
+        evictToFit(bytes);
+        directory = m_directory;
+    }
+
+    // Write under a temporary name and rename, so an entry is never seen half written
+    std::string temporary = directory + name + ".tmp" + std::to_string(m_tempCounter++);
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, &header, sizeof(header));
+    int srcPitch = texture.planePitch(0);
+    for (int y = 0; ok && y < texture.height; y++) {
+        ok = writeAll(fd, texture.pixels + static_cast<size_t>(y) * srcPitch, header.pitch);
+    }
+    ok = ::close(fd) == 0 && ok;
+    std::string path = directory + name;
+    if (!ok || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "Image disk cache: failed to write " << name << ": " << std::strerror(errno) << std::endl;
+        ::unlink(temporary.c_str());
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(name);
+        if (it != m_entries.end()) remove(it);
+        add(name, bytes);
+    }
+    m_writes++;
+
+    // Serve the image from the page cache from now on, which the kernel can
+    // reclaim, rather than from the heap
+    Texture mapped;
+    if (mapEntry(path, mapped)) texture = std::move(mapped);
+    return true;
+}
+
+ImageDiskCache::Stats ImageDiskCache::getStats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.entries = m_entries.size();
+        stats.bytes = m_bytes;
+        stats.maxBytes = m_maxBytes;
+    }
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.writes = m_writes;
+    stats.evictions = m_evictions;
+    return stats;
+}
+
+void ImageDiskCache::add(const std::string& name, size_t bytes) {
+    Entry& entry = m_entries[name];
+    entry.bytes = bytes;
+    m_lru.push_front(name);
+    entry.lruPosition = m_lru.begin();
+    m_bytes += bytes;
+}
+
+void ImageDiskCache::remove(std::map<std::string, Entry>::iterator it) {
+    // Images still mapped keep their pages until unmapped
+    std::error_code ec;
+    std::filesystem::remove(m_directory + it->first, ec);
+    m_bytes -= it->second.bytes;
+    m_lru.erase(it->second.lruPosition);
+    m_entries.erase(it);
+}
+
+void ImageDiskCache::evictToFit(size_t incoming) {
+    while (!m_lru.empty() && m_bytes + incoming > m_maxBytes) {
+        remove(m_entries.find(m_lru.back()));
+        m_evictions++;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "texture.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Display-ready images on the data partition, so a file decoded once for a
+// given display size is not decoded again, even after a reboot. Entries are
+// raw RGBA behind a small header, named after a hash of the source path, its
+// mtime and size, and the target size; editing or replacing the source simply
+// stops matching the old entry. Loading maps the file instead of reading it,
+// so a hit costs page faults rather than a decode.
+//
+// Total size is capped; the least recently used entries are deleted first.
+// Use is recorded in each file's mtime, so the order survives restarts.
+class ImageDiskCache {
+public:
+    // Use `directory` (created if missing) and index the entries already in
+    // it. Returns false, leaving the cache disabled, if it is not writable.
+    bool open(const std::string& directory, size_t maxBytes);
+    bool isOpen() const;
+
+    // Map the entry for `sourcePath` decoded for targetWidth x targetHeight
+    bool load(const std::string& sourcePath, int targetWidth, int targetHeight, Texture& texture);
+
+    // Save a freshly decoded RGBA `texture` as that entry. On success the
+    // texture is switched to the mapped file and its heap copy is freed.
+    bool store(const std::string& sourcePath, int targetWidth, int targetHeight, Texture& texture);
+
+    struct Stats {
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t maxBytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t writes = 0;
+        uint64_t evictions = 0;
+    };
+    Stats getStats() const;
+
+private:
+    struct Entry {
+        size_t bytes = 0;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    // Entry file name for the current version of `sourcePath`; false if the
+    // source cannot be stat'ed
+    static bool entryName(const std::string& sourcePath, int targetWidth, int targetHeight, std::string& name);
+    static bool mapEntry(const std::string& path, Texture& texture);
+
+    // The following must be called with m_mutex held
+    void add(const std::string& name, size_t bytes);
+    void remove(std::map<std::string, Entry>::iterator it);
+    void evictToFit(size_t incoming);
+
+    mutable std::mutex m_mutex;
+    std::string m_directory;
+    size_t m_maxBytes = 0;
+    size_t m_bytes = 0;
+    std::map<std::string, Entry> m_entries;
+    std::list<std::string> m_lru;   // most recently used first
+
+    std::atomic<bool> m_open{false};
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_writes{0};
+    std::atomic<uint64_t> m_evictions{0};
+    std::atomic<uint64_t> m_tempCounter{0};
+};
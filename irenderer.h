@@ -1,5 +1,9 @@
 #pragma once
 #include "texture.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
 
 class IRenderer {
 public:
@@ -7,6 +11,14 @@ public:
     virtual bool init(int width, int height, const char* title, bool fullscreen, int monitorIndex) = 0;
     virtual void processInput() = 0;
     virtual void render(const Texture& texture) = 0;
+    // Draw a still image. `version` changes whenever the pixels behind `name`
+    // do, so renderers may keep the image resident on the GPU and skip the
+    // upload while it stays the same.
+    virtual void renderStill(const std::string& name, uint64_t version, const Texture& texture) {
+        (void)name;
+        (void)version;
+        render(texture);
+    }
     virtual void renderOverlay(const Texture& overlay) { (void)overlay; }
     virtual void present() {}
     virtual bool shouldClose() const = 0;
@@ -14,6 +26,38 @@ public:
     virtual void setRotation(int degrees) { (void)degrees; }
     virtual int getWidth() const { return 0; }
     virtual int getHeight() const { return 0; }
+    // Size still images need to be decoded at to fill the display, in image
+    // orientation (swapped for quarter-turn rotations). 0 x 0 when images are
+    // shown 1:1 and have to keep their full resolution.
+    virtual void getImageTargetSize(int& width, int& height) const { width = 0; height = 0; }
+    // True if render() accepts ColorFormat::YUV420P (three single-channel planes)
+    virtual bool supportsPlanarYUV() const { return false; }
+
+    // Draw up to Mosaic::MAX_TILES frames as a columns x rows grid, each
+    // letterboxed in its cell. Invalid tiles are left black. Renderers without
+    // a mosaic path show the first available tile full screen.
+    virtual void renderMosaic(const std::vector<Texture>& tiles, int columns, int rows) {
+        (void)columns;
+        (void)rows;
+        for (const auto& tile : tiles) {
+            if (tile.isValid()) {
+                render(tile);
+                return;
+            }
+        }
+    }
+
+    // Program-feed readback for outputs such as the NDI sender.
+    // requestOutputCapture() asks for the frame being composited to be scaled
+    // to width x height and read back without stalling the render loop; the
+    // result reaches the sink (RGBA, top row first) from a later present().
+    // Each channel has its own readback buffers, so outputs at different
+    // sizes can be captured from the same frame.
+    enum OutputChannel { OUTPUT_NDI = 0, OUTPUT_PREVIEW = 1, OUTPUT_CHANNELS = 2 };
+    using OutputSink = std::function<void(int channel, const uint8_t* rgba, int width, int height, int stride)>;
+    virtual bool supportsOutputCapture() const { return false; }
+    virtual void setOutputSink(OutputSink sink) { (void)sink; }
+    virtual void requestOutputCapture(int channel, int width, int height) { (void)channel; (void)width; (void)height; }
 
 protected:
     bool m_fullscreenScaling = false;
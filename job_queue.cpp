@@ -0,0 +1,93 @@
+#include "job_queue.h"
+
+JobQueue::JobQueue(int workers) {
+    for (int i = 0; i < workers; i++) {
+        m_workers.emplace_back(&JobQueue::workerLoop, this);
+    }
+}
+
+JobQueue::~JobQueue() {
+    shutdown();
+}
+
+uint64_t JobQueue::submit(const std::string& key, Work work, Dropped dropped) {
+    auto job = std::make_shared<Job>();
+    job->key = key;
+    job->work = std::move(work);
+    job->dropped = std::move(dropped);
+
+    std::vector<std::shared_ptr<Job>> superseded;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        job->id = m_nextId++;
+        if (m_stopping) {
+            superseded.push_back(job);
+        } else {
+            for (auto it = m_queue.begin(); it != m_queue.end();) {
+                if ((*it)->key == key) {
+                    superseded.push_back(*it);
+                    it = m_queue.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            auto running = m_running.find(key);
+            if (running != m_running.end()) running->second->cancelled = true;
+            m_queue.push_back(job);
+        }
+    }
+    m_cv.notify_one();
+
+    // Report outside the lock; handlers may submit follow-up jobs
+    for (const auto& old : superseded) {
+        if (old->dropped) old->dropped(old->id, old == job ? 0 : job->id);
+    }
+    return job->id;
+}
+
+void JobQueue::shutdown() {
+    std::deque<std::shared_ptr<Job>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping && m_workers.empty()) return;
+        m_stopping = true;
+        dropped.swap(m_queue);
+        for (auto& [key, job] : m_running) job->cancelled = true;
+    }
+    m_cv.notify_all();
+
+    for (const auto& job : dropped) {
+        if (job->dropped) job->dropped(job->id, 0);
+    }
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) worker.join();
+    }
+    m_workers.clear();
+}
+
+void JobQueue::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        // Oldest job whose key is not already running
+        auto next = m_queue.end();
+        m_cv.wait(lock, [&] {
+            if (m_stopping) return true;
+            next = m_queue.begin();
+            while (next != m_queue.end() && m_running.count((*next)->key)) ++next;
+            return next != m_queue.end();
+        });
+        if (m_stopping) return;
+
+        std::shared_ptr<Job> job = *next;
+        m_queue.erase(next);
+        m_running[job->key] = job;
+
+        lock.unlock();
+        job->work(job->id, job->cancelled);
+        lock.lock();
+
+        m_running.erase(job->key);
+        // The next job of this key may have been waiting on this one
+        m_cv.notify_all();
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs slow control-plane work (stream probing, image decoding, receiver
+// start-up) off the WebSocket thread. Jobs that share a key run one at a time
+// in submission order, and submitting a job cancels the older jobs of its key:
+// queued ones are dropped without running and a running one sees `cancelled`
+// become true, so it can back out instead of applying a stale result.
+class JobQueue {
+public:
+    using Work = std::function<void(uint64_t id, const std::atomic<bool>& cancelled)>;
+    // Called instead of Work for a job that never ran. `supersededBy` is the
+    // job that replaced it, or 0 when the queue is shutting down.
+    using Dropped = std::function<void(uint64_t id, uint64_t supersededBy)>;
+
+    explicit JobQueue(int workers = 2);
+    ~JobQueue();
+
+    // Returns the new job's id (never 0)
+    uint64_t submit(const std::string& key, Work work, Dropped dropped);
+
+    // Drop queued jobs, cancel running ones and join the workers
+    void shutdown();
+
+private:
+    struct Job {
+        uint64_t id = 0;
+        std::string key;
+        Work work;
+        Dropped dropped;
+        std::atomic<bool> cancelled{false};
+    };
+
+    void workerLoop();
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::shared_ptr<Job>> m_queue;
+    std::map<std::string, std::shared_ptr<Job>> m_running;  // by key
+    std::vector<std::thread> m_workers;
+    uint64_t m_nextId = 1;
+    bool m_stopping = false;
+};
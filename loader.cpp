@@ -6,10 +6,76 @@
 #include <format>
 #include <iostream>
 #include <cstring>
+#include <cstdio>
+#include <csetjmp>
+#include <algorithm>
+#include <memory>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "pixel_ops.h"
+#ifdef HAVE_LIBJPEG
+#include <jpeglib.h>
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+namespace {
+#ifdef HAVE_LIBJPEG
+    // libjpeg's default handler exits the process; jump back to the decoder instead
+    struct JpegErrorManager {
+        jpeg_error_mgr base;
+        std::jmp_buf jump;
+    };
+
+    void jpegErrorExit(j_common_ptr cinfo) {
+        char message[JMSG_LENGTH_MAX];
+        cinfo->err->format_message(cinfo, message);
+        std::cerr << "JPEG decode error: " << message << std::endl;
+        std::longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+    }
+#endif
+
+    // Shrink tightly packed w x h RGBA `src` to width x height: 2x2 box
+    // passes while the image is at least twice the target, then one area pass
+    std::vector<unsigned char> downscaleRGBA(const unsigned char* src, int w, int h, int width, int height) {
+        std::vector<unsigned char> data;
+        while (w / 2 >= width && h / 2 >= height) {
+            std::vector<unsigned char> half(static_cast<size_t>(w / 2) * (h / 2) * 4);
+            PixelOps::halveRGBA(half.data(), (w / 2) * 4, src, w * 4, w, h);
+            data.swap(half);
+            src = data.data();
+            w /= 2;
+            h /= 2;
+        }
+        if (w != width || h != height) {
+            std::vector<unsigned char> scaled(static_cast<size_t>(width) * height * 4);
+            PixelOps::areaDownscaleRGBA(scaled.data(), width * 4, src, w * 4, w, h, width, height);
+            data.swap(scaled);
+        }
+        return data;
+    }
+}
+
+std::shared_ptr<void> Loader::MapFile(const std::string& filename, size_t& size) {
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    size = static_cast<size_t>(info.st_size);
+    // Private and writable: texture pixels are not const, but nothing reaches the file
+    void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) return nullptr;
+    size_t length = size;
+    return std::shared_ptr<void>(base, [length](void* p) { ::munmap(p, length); });
+}
+
 std::vector<char> Loader::readFile(const std::string& filename) {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
     std::cout << "Opening file: " << filename << std::endl;
@@ -69,31 +135,178 @@ std::vector<char> Loader::LoadShader(std::string shaderFilename)
     }
 }
 
-Texture Loader::LoadTexture(std::string textureFilename, ColorFormat format)
+void Loader::ScaledSize(int width, int height, int targetWidth, int targetHeight,
+                        int& scaledWidth, int& scaledHeight)
+{
+    scaledWidth = width;
+    scaledHeight = height;
+    if (targetWidth <= 0 || targetHeight <= 0 || width <= 0 || height <= 0) return;
+
+    // Keep the aspect ratio and cover the target on both axes
+    double scale = std::max(static_cast<double>(targetWidth) / width,
+                            static_cast<double>(targetHeight) / height);
+    if (scale >= 1.0) return;
+    scaledWidth = std::clamp(static_cast<int>(width * scale + 0.5), 1, width);
+    scaledHeight = std::clamp(static_cast<int>(height * scale + 0.5), 1, height);
+}
+
+bool Loader::decodeJpegScaled(const std::string& path, int targetWidth, int targetHeight,
+                              std::vector<unsigned char>& data, int& width, int& height, int& channels)
+{
+#ifdef HAVE_LIBJPEG
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    unsigned char magic[3] = {};
+    bool isJpeg = std::fread(magic, 1, 3, file) == 3 &&
+                  magic[0] == 0xFF && magic[1] == 0xD8 && magic[2] == 0xFF;
+    if (!isJpeg) {
+        std::fclose(file);
+        return false;
+    }
+    std::rewind(file);
+
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager jerr;
+    cinfo.err = jpeg_std_error(&jerr.base);
+    jerr.base.error_exit = jpegErrorExit;
+#ifndef JCS_EXTENSIONS
+    // Declared before setjmp, so an error's longjmp skips no destructors
+    std::vector<unsigned char> rgb;
+#endif
+    if (setjmp(jerr.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        std::fclose(file);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, file);
+    jpeg_read_header(&cinfo, TRUE);
+
+    // CMYK and other exotic colour spaces are left to stb_image
+    if (cinfo.jpeg_color_space != JCS_GRAYSCALE && cinfo.jpeg_color_space != JCS_YCbCr &&
+        cinfo.jpeg_color_space != JCS_RGB) {
+        jpeg_destroy_decompress(&cinfo);
+        std::fclose(file);
+        return false;
+    }
+
+    // Let the IDCT do the bulk of the reduction: the largest 1/2, 1/4 or 1/8
+    // scale that still leaves the image at least as large as the final size
+    int finalWidth = 0;
+    int finalHeight = 0;
+    ScaledSize(cinfo.image_width, cinfo.image_height, targetWidth, targetHeight, finalWidth, finalHeight);
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1;
+    for (unsigned denom = 8; denom > 1; denom /= 2) {
+        if ((cinfo.image_width + denom - 1) / denom >= static_cast<unsigned>(finalWidth) &&
+            (cinfo.image_height + denom - 1) / denom >= static_cast<unsigned>(finalHeight)) {
+            cinfo.scale_denom = denom;
+            break;
+        }
+    }
+#ifdef JCS_EXTENSIONS
+    cinfo.out_color_space = JCS_EXT_RGBA;
+#else
+    cinfo.out_color_space = JCS_RGB;
+#endif
+    jpeg_start_decompress(&cinfo);
+
+    width = static_cast<int>(cinfo.output_width);
+    height = static_cast<int>(cinfo.output_height);
+    channels = cinfo.num_components;
+    data.resize(static_cast<size_t>(width) * height * 4);
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+#ifndef JCS_EXTENSIONS
+    rgb.resize(static_cast<size_t>(width) * 3);
+#endif
+    while (cinfo.output_scanline < cinfo.output_height) {
+        unsigned char* out = data.data() + cinfo.output_scanline * rowBytes;
+#ifdef JCS_EXTENSIONS
+        JSAMPROW rowPointer = out;
+        jpeg_read_scanlines(&cinfo, &rowPointer, 1);
+#else
+        JSAMPROW rowPointer = rgb.data();
+        jpeg_read_scanlines(&cinfo, &rowPointer, 1);
+        for (int x = 0; x < width; x++) {
+            out[x * 4 + 0] = rgb[x * 3 + 0];
+            out[x * 4 + 1] = rgb[x * 3 + 1];
+            out[x * 4 + 2] = rgb[x * 3 + 2];
+            out[x * 4 + 3] = 0xFF;
+        }
+#endif
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    std::fclose(file);
+    return true;
+#else
+    (void)path;
+    (void)targetWidth;
+    (void)targetHeight;
+    (void)data;
+    (void)width;
+    (void)height;
+    (void)channels;
+    return false;
+#endif
+}
+
+Texture Loader::LoadTexture(std::string textureFilename, ColorFormat format,
+                            int targetWidth, int targetHeight)
 {
     Texture texture;
     texture.format = format;
     
-    // For UYVY, we need to load raw data
+    // For UYVY, we need to load raw data; map the file rather than copy it
     if (format == ColorFormat::UYVY) {
-        std::vector<char> buffer = readFile(getTextureInPath(textureFilename));
-        std::vector<unsigned char> data(buffer.begin(), buffer.end());
-        texture.setOwnedPixels(std::move(data), 512, 512, 4, format);
+        constexpr int UYVY_SIZE = 512;
+        std::string path = getTextureInPath(textureFilename);
+        size_t size = 0;
+        std::shared_ptr<void> mapping = MapFile(path, size);
+        if (!mapping || size < static_cast<size_t>(UYVY_SIZE) * UYVY_SIZE * 2) {
+            throw std::runtime_error("failed to load texture image!");
+        }
+        unsigned char* data = static_cast<unsigned char*>(mapping.get());
+        texture.setSharedPixels(std::move(mapping), data, UYVY_SIZE, UYVY_SIZE, 4, format);
     } else {
+        std::string path = getTextureInPath(textureFilename);
         int w, h, ch;
-        unsigned char* raw = stbi_load(getTextureInPath(textureFilename).c_str(),
-                                       &w, &h, &ch, STBI_rgb_alpha);
-        if (!raw) {
-            throw std::runtime_error("failed to load texture image!");
+        std::vector<unsigned char> data;
+        std::shared_ptr<void> decoded;   // stb_image's own buffer, adopted without a copy
+        unsigned char* pixels = nullptr;
+        // JPEGs decode straight at a reduced scale when libjpeg is available
+        if (decodeJpegScaled(path, targetWidth, targetHeight, data, w, h, ch)) {
+            pixels = data.data();
+        } else {
+            pixels = stbi_load(path.c_str(), &w, &h, &ch, STBI_rgb_alpha);
+            if (!pixels) {
+                throw std::runtime_error("failed to load texture image!");
+            }
+            decoded.reset(pixels, stbi_image_free);
+        }
+
+        int scaledWidth = w;
+        int scaledHeight = h;
+        ScaledSize(w, h, targetWidth, targetHeight, scaledWidth, scaledHeight);
+        if (scaledWidth != w || scaledHeight != h) {
+            std::vector<unsigned char> scaled = downscaleRGBA(pixels, w, h, scaledWidth, scaledHeight);
+            texture.setOwnedPixels(std::move(scaled), scaledWidth, scaledHeight, ch, format);
+        } else if (decoded) {
+            texture.setSharedPixels(std::move(decoded), pixels, w, h, ch, format);
+        } else {
+            texture.setOwnedPixels(std::move(data), w, h, ch, format);
         }
-        size_t size = static_cast<size_t>(w) * h * 4;
-        std::vector<unsigned char> data(raw, raw + size);
-        stbi_image_free(raw);
-        texture.setOwnedPixels(std::move(data), w, h, ch, format);
     }
 
     if (!texture.pixels) {
         throw std::runtime_error("failed to load texture image!");
     }
     return texture;
-}
\ No newline at end of file
+}
+
+bool Loader::ProbeTexture(std::string textureFilename, int& width, int& height)
+{
+    int channels = 0;
+    return stbi_info(getTextureInPath(textureFilename).c_str(), &width, &height, &channels) != 0;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include <string>
 #include <vector>
 #include "texture.h"
@@ -6,10 +7,23 @@
 class Loader {
 public:
     std::vector<char> LoadShader(std::string shaderFilename);
-    Texture LoadTexture(std::string textureFilename, ColorFormat format = ColorFormat::RGBA);
+    // A non-zero target scales still images down at decode time so they
+    // still cover targetWidth x targetHeight; images are never scaled up
+    Texture LoadTexture(std::string textureFilename, ColorFormat format = ColorFormat::RGBA,
+                        int targetWidth = 0, int targetHeight = 0);
+    // Read an image's dimensions from its header without decoding it
+    bool ProbeTexture(std::string textureFilename, int& width, int& height);
+    // Map a whole file read-only (copy-on-write); the mapping lives as long
+    // as the returned pointer and its copies. Null if the file can't be mapped.
+    static std::shared_ptr<void> MapFile(const std::string& filename, size_t& size);
+    // Size LoadTexture() gives a width x height image for the given target
+    static void ScaledSize(int width, int height, int targetWidth, int targetHeight,
+                           int& scaledWidth, int& scaledHeight);
 
 private:
     std::vector<char> readFile(const std::string& filename);
     std::string getShaderInPath(std::string shaderFilename);
     std::string getTextureInPath(std::string textureFilename);
+    bool decodeJpegScaled(const std::string& path, int targetWidth, int targetHeight,
+                          std::vector<unsigned char>& data, int& width, int& height, int& channels);
 };
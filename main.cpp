@@ -4,12 +4,20 @@
 #include "loader.h"
 #include "config.h"
 #include "ndireceiver.h"
+#include "ndi_multiview.h"
+#include "ndisender.h"
+#include "preview_stream.h"
+#include "render_stats.h"
+#include "frame_boundary.h"
 #include "texture_manager.h"
+#include "media_index.h"
+#include "media_probe_cache.h"
 #include "websocket_server.h"
 #include "splash_controller.h"
 #include "mdns_advertiser.h"
 #include "log.h"
 #include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <filesystem>
@@ -84,10 +92,15 @@ int main(int argc, char* argv[]) {
 #endif
 
     NDIReceiver ndiReceiver;
+    NDIMultiview ndiMultiview(ndiReceiver);
+    NDISender ndiSender(ndiReceiver);
+    PreviewStream previewStream;
 
     TextureManager textureManager;
-    std::string textureName;
-    textureManager.scanTextureDirectory();  // Scan current directory for textures
+    textureManager.setCacheBudget(static_cast<size_t>(std::max(config.textureCacheMB, 0)) * 1024 * 1024);
+    if (config.imageDiskCacheMB > 0) {
+        textureManager.openDiskCache(IMAGE_CACHE_PATH, static_cast<size_t>(config.imageDiskCacheMB) * 1024 * 1024);
+    }
 
     // Initialize mDNS advertiser
     MDNSAdvertiser mdnsAdvertiser(config.instanceName, config.wsPort);
@@ -96,6 +109,21 @@ int main(int argc, char* argv[]) {
     WebSocketServer wsServer(textureManager, config.wsPort);
     wsServer.setMDNSAdvertiser(&mdnsAdvertiser);
     wsServer.setConfiguration(&config);
+
+    // Metadata of the media files, probed in the background and kept on /data
+    MediaProbeCache probeCache(MEDIA_PATH, MEDIA_INFO_PATH);
+    probeCache.start();
+    wsServer.setMediaProbeCache(&probeCache);
+
+    // Image and video lists follow uploads to media/ without rescans
+    MediaIndex mediaIndex(MEDIA_PATH);
+    mediaIndex.setOnChange([&](const MediaIndex::Change& change) {
+        textureManager.applyMediaChange(change);
+        probeCache.applyMediaChange(change);
+        wsServer.publishMediaChange(change);
+    });
+    mediaIndex.start();
+    wsServer.setMediaIndex(&mediaIndex);
     wsServer.start();
     
     // Publish mDNS service (warns and continues if Avahi unavailable)
@@ -117,25 +145,66 @@ int main(int argc, char* argv[]) {
     renderer->setRotation(config.displayRotation);
     wsServer.setRenderer(renderer.get());
 
+    // Decode still images at display resolution rather than file resolution
+    int imageWidth = 0;
+    int imageHeight = 0;
+    renderer->getImageTargetSize(imageWidth, imageHeight);
+    textureManager.setTargetSize(imageWidth, imageHeight);
+
     // Load default texture for image mode
     if (!textureManager.loadTexture("default.jpg")) {
         std::cerr << "Failed to load default texture" << std::endl;
         return -1;
     }
     textureManager.setCurrentTexture("default.jpg");
-    Texture displayTexture = textureManager.getCurrentTextureCopy();
+    uint64_t textureGeneration = textureManager.getCurrentGeneration();
+    auto displayTexture = textureManager.getCurrent();
 
     ndiReceiver.loadRuntime();  // Loads libndi.so if present, no-op if not
     wsServer.setNDIReceiver(&ndiReceiver);
+    wsServer.setNDIMultiview(&ndiMultiview);
+    wsServer.setNDISender(&ndiSender);
+    wsServer.setPreviewStream(&previewStream);
+    RenderStats renderStats;
+    wsServer.setRenderStats(&renderStats);
+    FrameBoundary frameBoundary;
+    wsServer.setFrameBoundary(&frameBoundary);
+    ndiReceiver.setFrameSync(config.ndiFrameSync);
     if (config.ndiMode && ndiReceiver.isRuntimeLoaded()) {
         if (!config.ndiSourceName.empty()) {
             ndiReceiver.setSource(config.ndiSourceName);
         }
         ndiReceiver.start();
     }
+    if (!config.ndiMultiviewSources.empty() && ndiReceiver.isRuntimeLoaded()) {
+        std::string error;
+        if (!ndiMultiview.start(config.ndiMultiviewSources, config.ndiMultiviewColumns,
+                                renderer->getWidth(), renderer->getHeight(), error)) {
+            std::cerr << "NDI: Multiview not started: " << error << std::endl;
+        }
+    }
+    if (config.ndiOutputEnabled && ndiReceiver.isRuntimeLoaded()) {
+        std::string error;
+        if (!renderer->supportsOutputCapture()) {
+            std::cerr << "NDI: Program output needs an OpenGL renderer" << std::endl;
+        } else if (!ndiSender.start(config.ndiOutputName, config.ndiOutputWidth, config.ndiOutputHeight,
+                                    config.ndiOutputFps, error)) {
+            std::cerr << "NDI: Program output not started: " << error << std::endl;
+        }
+    }
+    renderer->setOutputSink([&ndiSender, &previewStream](int channel, const uint8_t* rgba,
+                                                         int width, int height, int stride) {
+        if (channel == IRenderer::OUTPUT_NDI)
+            ndiSender.sendFrame(rgba, width, height, stride);
+        else if (channel == IRenderer::OUTPUT_PREVIEW)
+            previewStream.submitFrame(rgba, width, height, stride);
+    });
+    std::vector<Texture> mosaicTiles;
 
 #ifdef HAVE_FFMPEG
     auto videoDecoder = std::make_unique<VideoDecoder>();
+    videoDecoder->setPlanarOutput(renderer->supportsPlanarYUV());
+    videoDecoder->setProbeCache(&probeCache);
     wsServer.setVideoDecoder(videoDecoder.get());
 
     // Start single video if configured
@@ -191,6 +260,7 @@ int main(int argc, char* argv[]) {
     // Main render loop - fixed rate
     Texture videoFrame;
     MediaClock mediaClock;
+    uint64_t videoSeekGeneration = 0;
     double m_nextFramePts = 0.0;
     auto targetFrameTime = std::chrono::microseconds(1000000 / config.targetFps);
 
@@ -198,11 +268,12 @@ int main(int argc, char* argv[]) {
         auto frameStart = std::chrono::steady_clock::now();
 
         renderer->processInput();
+        frameBoundary.runPending();  // batched changes land together, before state is read
 
-        std::string currentName = textureManager.getCurrentTextureName();
-        if (currentName != textureName) {
-            displayTexture = textureManager.getCurrentTextureCopy();
-            textureName = currentName;
+        uint64_t generation = textureManager.getCurrentGeneration();
+        if (generation != textureGeneration) {
+            displayTexture = textureManager.getCurrent();
+            textureGeneration = generation;
         }
 
         bool rendered = false;
@@ -213,7 +284,15 @@ int main(int argc, char* argv[]) {
         if (videoDecoder && videoDecoder->isActive()) {
             bool gotFrame = false;
 
-            if (videoDecoder->isStream()) {
+            if (videoDecoder->isTestPattern()) {
+                // Synthetic source: always show the newest frame so drops and
+                // latency reflect the render path, not queue buffering
+                Texture nextFrame;
+                if (videoDecoder->getLatestFrame(nextFrame)) {
+                    videoFrame = nextFrame;
+                    gotFrame = true;
+                }
+            } else if (videoDecoder->isStream()) {
                 // Streams: consume from queue with adaptive rate.
                 // When buffer is healthy, consume one per tick.
                 // When buffer is low, skip consumption to let it refill.
@@ -242,18 +321,26 @@ int main(int argc, char* argv[]) {
                 }
             } else {
                 // File playback: PTS-based timing via media clock
+                uint64_t seekGeneration = videoDecoder->seekGeneration();
+                if (seekGeneration != videoSeekGeneration) {
+                    // Frames from a new position are arriving; keep showing
+                    // the last one until the first of them is there
+                    videoSeekGeneration = seekGeneration;
+                    mediaClock.reset();
+                }
                 if (!mediaClock.started) {
                     Texture firstFrame;
-                    if (videoDecoder->getFrameForTime(0.0, firstFrame)) {
+                    double start = std::max(videoDecoder->seekPosition(), videoDecoder->oldestPts());
+                    if (videoDecoder->getFrameForTime(start, firstFrame)) {
                         videoFrame = firstFrame;
-                        mediaClock.sync(0.0);
+                        mediaClock.sync(start);
                         gotFrame = true;
-                        LOG_INFO("Media clock started");
+                        LOG_INFO("Media clock started at " << start << "s");
                     }
                 } else {
                     double t = mediaClock.time();
                     gotFrame = videoDecoder->getFrameForTime(t, videoFrame);
-                    videoDecoder->setPlaybackTime(t);
+                    videoDecoder->setPlaybackTime(t, videoSeekGeneration);
                 }
             }
 
@@ -261,6 +348,8 @@ int main(int argc, char* argv[]) {
                 renderer->render(videoFrame);
                 rendered = true;
                 frameCount++;
+                if (videoDecoder->isTestPattern())
+                    videoDecoder->onFramePresented(videoFrame);
             }
 
             // Log stats every 5 seconds
@@ -280,6 +369,14 @@ int main(int argc, char* argv[]) {
         }
 #endif
 
+        int mosaicColumns = 0;
+        int mosaicRows = 0;
+        if (!rendered && ndiMultiview.getTiles(mosaicTiles, mosaicColumns, mosaicRows)) {
+            renderer->renderMosaic(mosaicTiles, mosaicColumns, mosaicRows);
+            mosaicTiles.clear();  // release the NDI frames until the next tick
+            rendered = true;
+        }
+
         if (!rendered && config.ndiMode && ndiReceiver.isConnected()) {
             Texture currentFrame;
             if (ndiReceiver.getLatestFrame(currentFrame)) {
@@ -288,8 +385,8 @@ int main(int argc, char* argv[]) {
             }
         }
 
-        if (!rendered && displayTexture.isValid()) {
-            renderer->render(displayTexture);
+        if (!rendered && displayTexture && displayTexture->texture.isValid()) {
+            renderer->renderStill(displayTexture->name, displayTexture->version, displayTexture->texture);
         }
 
         if (splashController.isActive()) {
@@ -299,16 +396,33 @@ int main(int argc, char* argv[]) {
             }
         }
 
+        int outputWidth = 0;
+        int outputHeight = 0;
+        if (ndiSender.frameDue(outputWidth, outputHeight)) {
+            renderer->requestOutputCapture(IRenderer::OUTPUT_NDI, outputWidth, outputHeight);
+        }
+        if (previewStream.frameDue(renderer->getWidth(), renderer->getHeight(), outputWidth, outputHeight)) {
+            renderer->requestOutputCapture(IRenderer::OUTPUT_PREVIEW, outputWidth, outputHeight);
+        }
+
+        auto presentStart = std::chrono::steady_clock::now();
         renderer->present();
 
         // Fixed frame rate cap
         auto frameEnd = std::chrono::steady_clock::now();
+        renderStats.presentDone(frameEnd - presentStart);
         auto elapsed = frameEnd - frameStart;
+        renderStats.frameDone(elapsed, targetFrameTime);
         if (elapsed < targetFrameTime) {
             std::this_thread::sleep_for(targetFrameTime - elapsed);
         }
     }
 
+    frameBoundary.close();
+    renderer->setOutputSink(nullptr);
+    previewStream.stop();
+    ndiSender.stop();
+    ndiMultiview.stop();
     ndiReceiver.stop();
 
 #ifdef HAVE_FFMPEG
@@ -318,6 +432,8 @@ int main(int argc, char* argv[]) {
 #endif
 
     // Before return, stop WebSocket server
+    mediaIndex.stop();
+    probeCache.stop();
     wsServer.stop();
     return 0;
 }
\ No newline at end of file
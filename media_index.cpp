@@ -0,0 +1,269 @@
+#include "media_index.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sys/stat.h>
+#include "file_stat.h"
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef __linux__
+    constexpr int WATCH_RETRY_MS = 1000;   // while the directory is missing
+
+    constexpr uint32_t WATCH_EVENTS = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM |
+                                      IN_MOVED_TO | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+    std::string lowerExtension(const std::string& name) {
+        std::string ext = std::filesystem::path(name).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext;
+    }
+
+    // Hidden names are partial uploads of tools like rsync
+    bool isMediaFile(const std::string& name) {
+        return !name.empty() && name[0] != '.' && (MediaIndex::isImage(name) || MediaIndex::isVideo(name));
+    }
+
+    bool sameFile(const struct stat& st, int64_t size, int64_t mtimeNs) {
+        return st.st_size == size && statMtimeNs(st) == mtimeNs;
+    }
+}
+
+MediaIndex::MediaIndex(const std::string& directory) : m_directory(directory) {
+    if (!m_directory.empty() && m_directory.back() != '/') m_directory += '/';
+}
+
+MediaIndex::~MediaIndex() {
+    stop();
+}
+
+bool MediaIndex::isImage(const std::string& name) {
+    std::string ext = lowerExtension(name);
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png";
+}
+
+bool MediaIndex::isVideo(const std::string& name) {
+    std::string ext = lowerExtension(name);
+    return ext == ".mp4" || ext == ".mkv" || ext == ".mov" ||
+           ext == ".avi" || ext == ".webm" || ext == ".flv";
+}
+
+void MediaIndex::setOnChange(ChangeCallback callback) {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    m_onChange = std::move(callback);
+}
+
+void MediaIndex::start() {
+#ifdef __linux__
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_inotifyFd < 0 || m_wakeFd < 0) {
+        std::cerr << "Media index: inotify unavailable (" << std::strerror(errno)
+                  << "), use scan_textures / scan_videos after uploads" << std::endl;
+        rescan();
+        return;
+    }
+    // Watch before scanning, so nothing written in between is missed
+    addWatch();
+    rescan();
+    m_thread = std::thread(&MediaIndex::watchLoop, this);
+#else
+    std::cerr << "Media index: no file watcher on this platform, use scan_textures / scan_videos after uploads"
+              << std::endl;
+    rescan();
+#endif
+}
+
+void MediaIndex::stop() {
+    m_stopping = true;
+#ifdef __linux__
+    if (m_wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(m_wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+#endif
+    if (m_thread.joinable()) m_thread.join();
+#ifdef __linux__
+    if (m_inotifyFd >= 0) ::close(m_inotifyFd);
+    if (m_wakeFd >= 0) ::close(m_wakeFd);
+    m_inotifyFd = -1;
+    m_wakeFd = -1;
+#endif
+    m_watching = false;
+}
+
+#ifdef __linux__
+bool MediaIndex::addWatch() {
+    m_watchFd = inotify_add_watch(m_inotifyFd, m_directory.c_str(), WATCH_EVENTS);
+    m_watching = m_watchFd >= 0;
+    return m_watching;
+}
+#endif
+
+void MediaIndex::rescan() {
+    std::lock_guard<std::mutex> update(m_updateMutex);
+    Change change;
+
+    // Every name either on disk or in the index gets refreshed
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory, ec)) {
+        names.push_back(entry.path().filename().string());
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& [name, state] : m_files) names.push_back(name);
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    for (const auto& name : names) refresh(name, change);
+
+    notify(change);
+}
+
+void MediaIndex::refresh(const std::string& name, Change& change) {
+    struct stat st;
+    bool present = isMediaFile(name) && ::stat((m_directory + name).c_str(), &st) == 0 && S_ISREG(st.st_mode);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_files.find(name);
+    if (!present) {
+        if (it == m_files.end()) return;
+        m_files.erase(it);
+        change.removed.push_back(name);
+        return;
+    }
+    if (it != m_files.end() && sameFile(st, it->second.size, it->second.mtimeNs)) return;
+
+    (it == m_files.end() ? change.added : change.modified).push_back(name);
+    FileState& state = m_files[name];
+    state.size = st.st_size;
+    state.mtimeNs = statMtimeNs(st);
+}
+
+void MediaIndex::notify(const Change& change) {
+    if (change.empty()) return;
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    if (m_onChange) m_onChange(change);
+}
+
+#ifdef __linux__
+void MediaIndex::watchLoop() {
+    while (!m_stopping) {
+        // Sleep until the next file settles, or indefinitely
+        int timeout = -1;
+        if (!m_watching) timeout = WATCH_RETRY_MS;
+        if (!m_pending.empty()) {
+            auto next = std::min_element(m_pending.begin(), m_pending.end(),
+                                         [](const auto& a, const auto& b) { return a.second < b.second; });
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next->second - std::chrono::steady_clock::now());
+            int pendingTimeout = static_cast<int>(std::max<int64_t>(wait.count() + 1, 0));
+            timeout = timeout < 0 ? pendingTimeout : std::min(timeout, pendingTimeout);
+        }
+
+        pollfd fds[2] = { { m_inotifyFd, POLLIN, 0 }, { m_wakeFd, POLLIN, 0 } };
+        int ready = ::poll(fds, 2, timeout);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "Media index: poll failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (m_stopping) return;
+        if (ready > 0 && (fds[0].revents & POLLIN)) readEvents();
+
+        if (!m_watching && addWatch()) {
+            std::cout << "Media index: watching " << m_directory << std::endl;
+            rescan();
+        }
+        settleDue();
+    }
+}
+
+void MediaIndex::readEvents() {
+    alignas(inotify_event) char buffer[16 * 1024];
+    auto now = std::chrono::steady_clock::now();
+    bool rescanNeeded = false;
+
+    while (true) {
+        ssize_t length = ::read(m_inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) break;   // EAGAIN: drained
+
+        for (char* p = buffer; p < buffer + length; ) {
+            auto* event = reinterpret_cast<inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                rescanNeeded = true;
+                continue;
+            }
+            if (!m_watching || event->wd != m_watchFd) continue;   // left over from a removed watch
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                // The directory itself went away; watch for it to come back
+                if (!(event->mask & IN_IGNORED)) inotify_rm_watch(m_inotifyFd, m_watchFd);
+                m_watching = false;
+                rescanNeeded = true;
+                continue;
+            }
+            if (event->len == 0) continue;
+            std::string name(event->name);
+            if (!isMediaFile(name)) continue;
+
+            // Still being written: wait for the close, or give up on the writer
+            // after a long pause. Anything else settles shortly.
+            bool writing = (event->mask & (IN_CREATE | IN_MODIFY)) != 0;
+            m_pending[name] = now + std::chrono::milliseconds(writing ? STALLED_WRITE_MS : SETTLE_MS);
+        }
+    }
+
+    if (rescanNeeded) {
+        // Events were lost, or the directory went away; the rescan covers the pending files
+        m_pending.clear();
+        rescan();
+    }
+}
+#endif
+
+void MediaIndex::settleDue() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::string> due;
+    for (auto it = m_pending.begin(); it != m_pending.end(); ) {
+        if (it->second <= now) {
+            due.push_back(it->first);
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (due.empty()) return;
+
+    std::lock_guard<std::mutex> update(m_updateMutex);
+    Change change;
+    for (const auto& name : due) refresh(name, change);
+    notify(change);
+}
+
+std::vector<std::string> MediaIndex::getImages() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::string> images;
+    for (const auto& [name, state] : m_files) {
+        if (isImage(name)) images.push_back(name);
+    }
+    return images;
+}
+
+std::vector<std::string> MediaIndex::getVideos() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::string> videos;
+    for (const auto& [name, state] : m_files) {
+        if (isVideo(name)) videos.push_back(name);
+    }
+    return videos;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The images and videos in the media directory, kept up to date with inotify
+// (Linux only) instead of rescanning it. A file only enters (or changes in) the index once
+// it has settled: shortly after its writer closes it or it is moved into
+// place, so an upload still in progress over SCP is not picked up half
+// written. A write that stalls without closing the file is taken as it is
+// after STALLED_WRITE_MS.
+//
+// Without inotify (other platforms, or when it can't be set up), or after its
+// event queue overflows, the directory is rescanned in full; rescan() also
+// does so on request.
+class MediaIndex {
+public:
+    static constexpr int SETTLE_MS = 500;
+    static constexpr int STALLED_WRITE_MS = 30000;
+
+    // Image and video file names affected by one scan or settled batch
+    struct Change {
+        std::vector<std::string> added;
+        std::vector<std::string> removed;
+        std::vector<std::string> modified;   // overwritten or replaced
+        bool empty() const { return added.empty() && removed.empty() && modified.empty(); }
+    };
+    // Called on the watcher thread, or on the thread calling rescan(), one
+    // change at a time; must not call back into the index's scans
+    using ChangeCallback = std::function<void(const Change& change)>;
+
+    explicit MediaIndex(const std::string& directory);
+    ~MediaIndex();
+
+    static bool isImage(const std::string& name);
+    static bool isVideo(const std::string& name);
+
+    void setOnChange(ChangeCallback callback);
+
+    // Scan the directory (reported as one change adding everything) and
+    // start watching it
+    void start();
+    void stop();
+
+    // Full scan; reports what differs from the index
+    void rescan();
+
+    // Sorted file names
+    std::vector<std::string> getImages() const;
+    std::vector<std::string> getVideos() const;
+    bool isWatching() const { return m_watching; }
+
+private:
+    struct FileState {
+        int64_t size = 0;
+        int64_t mtimeNs = 0;
+    };
+
+#ifdef __linux__
+    void watchLoop();
+    bool addWatch();
+    void readEvents();
+#endif
+    void settleDue();
+    // Bring `name` in line with the directory; records the difference in `change`.
+    // Must be called with m_updateMutex held.
+    void refresh(const std::string& name, Change& change);
+    void notify(const Change& change);
+
+    std::string m_directory;
+#ifdef __linux__
+    int m_inotifyFd = -1;
+    int m_watchFd = -1;
+    int m_wakeFd = -1;
+#endif
+    std::thread m_thread;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<bool> m_watching{false};
+
+    // Files with events waiting to settle; watcher thread only
+    std::map<std::string, std::chrono::steady_clock::time_point> m_pending;
+
+    std::mutex m_updateMutex;   // one scan or refresh at a time, callbacks in order
+    mutable std::mutex m_mutex; // guards m_files for readers
+    std::map<std::string, FileState> m_files;
+
+    std::mutex m_callbackMutex;
+    ChangeCallback m_onChange;
+};
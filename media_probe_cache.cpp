@@ -0,0 +1,391 @@
+#include "media_probe_cache.h"
+#include "loader.h"
+#include "picosha2.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <json/json.h>
+#include <sys/stat.h>
+#include "file_stat.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#ifdef HAVE_FFMPEG
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+#endif
+
+namespace {
+    constexpr size_t HASH_SAMPLE_BYTES = 64 * 1024;
+    constexpr int INDEX_VERSION = 1;
+
+    // Idle scheduling for this thread's CPU and disk time, so probing never
+    // competes with playback. Other platforms keep the default priority.
+    void lowerThreadPriority() {
+#ifdef __linux__
+        sched_param param = {};
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#ifdef SYS_ioprio_set
+        constexpr int IOPRIO_WHO_PROCESS = 1;
+        constexpr int IOPRIO_CLASS_IDLE = 3;
+        constexpr int IOPRIO_CLASS_SHIFT = 13;
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, static_cast<int>(syscall(SYS_gettid)),
+                IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+#elif defined(__APPLE__)
+        // Background band: low CPU priority and throttled disk I/O, this thread only
+        setpriority(PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG);
+#endif
+    }
+
+    bool statFile(const std::string& path, int64_t& size, int64_t& mtimeNs) {
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+        size = st.st_size;
+        mtimeNs = statMtimeNs(st);
+        return true;
+    }
+
+    // Content fingerprint that stays cheap for multi-gigabyte videos
+    std::string fingerprint(const std::string& path, int64_t size) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return std::string();
+        std::string data = std::to_string(size) + "\n";
+        std::vector<char> sample(HASH_SAMPLE_BYTES);
+        file.read(sample.data(), sample.size());
+        data.append(sample.data(), static_cast<size_t>(file.gcount()));
+        if (size > static_cast<int64_t>(2 * HASH_SAMPLE_BYTES)) {
+            file.clear();
+            file.seekg(size - static_cast<int64_t>(HASH_SAMPLE_BYTES));
+            file.read(sample.data(), sample.size());
+            data.append(sample.data(), static_cast<size_t>(file.gcount()));
+        }
+        return picosha2::hash256_hex_string(data);
+    }
+
+    // Videos need FFmpeg to be probed
+    bool canProbe(const std::string& name) {
+#ifdef HAVE_FFMPEG
+        return MediaIndex::isImage(name) || MediaIndex::isVideo(name);
+#else
+        return MediaIndex::isImage(name);
+#endif
+    }
+
+    Json::Value toJson(const MediaProbeCache::MediaInfo& info) {
+        Json::Value out;
+        out["type"] = info.type;
+        out["size"] = static_cast<Json::Int64>(info.size);
+        out["mtimeNs"] = static_cast<Json::Int64>(info.mtimeNs);
+        out["hash"] = info.hash;
+        out["container"] = info.container;
+        out["codec"] = info.codec;
+        out["width"] = info.width;
+        out["height"] = info.height;
+        out["fps"] = info.fps;
+        out["duration"] = info.duration;
+        out["keyframes"] = Json::arrayValue;
+        for (double time : info.keyframes) out["keyframes"].append(time);
+        return out;
+    }
+
+    MediaProbeCache::MediaInfo fromJson(const std::string& name, const Json::Value& in) {
+        MediaProbeCache::MediaInfo info;
+        info.name = name;
+        info.type = in.get("type", "").asString();
+        info.size = in.get("size", 0).asInt64();
+        info.mtimeNs = in.get("mtimeNs", 0).asInt64();
+        info.hash = in.get("hash", "").asString();
+        info.container = in.get("container", "").asString();
+        info.codec = in.get("codec", "").asString();
+        info.width = in.get("width", 0).asInt();
+        info.height = in.get("height", 0).asInt();
+        info.fps = in.get("fps", 0.0).asDouble();
+        info.duration = in.get("duration", -1.0).asDouble();
+        for (const auto& time : in["keyframes"]) info.keyframes.push_back(time.asDouble());
+        return info;
+    }
+}
+
+MediaProbeCache::MediaProbeCache(const std::string& directory, const std::string& indexPath)
+    : m_directory(directory), m_indexPath(indexPath) {
+    if (!m_directory.empty() && m_directory.back() != '/') m_directory += '/';
+}
+
+MediaProbeCache::~MediaProbeCache() {
+    stop();
+}
+
+void MediaProbeCache::start() {
+    load();
+    m_thread = std::thread(&MediaProbeCache::workerLoop, this);
+}
+
+void MediaProbeCache::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void MediaProbeCache::applyMediaChange(const MediaIndex::Change& change) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& name : change.removed) {
+            if (m_entries.erase(name)) m_dirty = true;
+        }
+        auto enqueue = [this](const std::string& name) {
+            if (canProbe(name) && m_queued.insert(name).second) m_queue.push_back(name);
+        };
+        for (const auto& name : change.added) enqueue(name);
+        for (const auto& name : change.modified) enqueue(name);
+    }
+    m_wake.notify_one();
+}
+
+bool MediaProbeCache::isCurrent(const MediaInfo& info) const {
+    int64_t size = 0;
+    int64_t mtimeNs = 0;
+    return statFile(m_directory + info.name, size, mtimeNs) && size == info.size && mtimeNs == info.mtimeNs;
+}
+
+bool MediaProbeCache::find(const std::string& name, MediaInfo& info) const {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(name);
+        if (it == m_entries.end()) return false;
+        info = it->second;
+    }
+    return isCurrent(info);
+}
+
+bool MediaProbeCache::findOrProbe(const std::string& name, MediaInfo& info) {
+    if (find(name, info)) return true;
+    if (!probe(name, info)) return false;
+    store(MediaInfo(info));
+    m_wake.notify_one();   // the worker saves it
+    return true;
+}
+
+std::vector<MediaProbeCache::MediaInfo> MediaProbeCache::getAll() const {
+    std::vector<MediaInfo> all;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& [name, info] : m_entries) all.push_back(info);
+    }
+    all.erase(std::remove_if(all.begin(), all.end(), [this](const MediaInfo& info) { return !isCurrent(info); }),
+              all.end());
+    return all;
+}
+
+MediaProbeCache::Stats MediaProbeCache::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.entries = m_entries.size();
+    stats.queued = m_queue.size();
+    stats.probes = m_probes;
+    stats.failures = m_failures;
+    return stats;
+}
+
+bool MediaProbeCache::probe(const std::string& name, MediaInfo& info) const {
+    std::string path = m_directory + name;
+    info = MediaInfo();
+    info.name = name;
+    if (!statFile(path, info.size, info.mtimeNs)) return false;
+    info.hash = fingerprint(path, info.size);
+
+    if (MediaIndex::isImage(name)) {
+        info.type = "image";
+        std::string ext = std::filesystem::path(name).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        info.codec = (ext == ".png") ? "png" : "jpeg";
+        Loader loader;
+        return loader.ProbeTexture(name, info.width, info.height);
+    }
+    if (MediaIndex::isVideo(name)) {
+        info.type = "video";
+        return probeVideo(path, info);
+    }
+    return false;
+}
+
+bool MediaProbeCache::probeVideo(const std::string& path, MediaInfo& info) const {
+#ifdef HAVE_FFMPEG
+    // Reading a file through can take minutes at idle priority; stop() must
+    // not wait for it, so every FFmpeg read checks for shutdown
+    AVFormatContext* formatCtx = avformat_alloc_context();
+    if (!formatCtx) return false;
+    formatCtx->interrupt_callback.callback = [](void* opaque) -> int {
+        return static_cast<const MediaProbeCache*>(opaque)->m_stopping.load() ? 1 : 0;
+    };
+    formatCtx->interrupt_callback.opaque = const_cast<MediaProbeCache*>(this);
+    if (avformat_open_input(&formatCtx, path.c_str(), nullptr, nullptr) < 0) return false;
+    if (avformat_find_stream_info(formatCtx, nullptr) < 0) {
+        avformat_close_input(&formatCtx);
+        return false;
+    }
+    int index = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (index < 0) {
+        avformat_close_input(&formatCtx);
+        return false;
+    }
+
+    AVStream* stream = formatCtx->streams[index];
+    info.container = formatCtx->iformat->name;
+    info.codec = avcodec_get_name(stream->codecpar->codec_id);
+    info.width = stream->codecpar->width;
+    info.height = stream->codecpar->height;
+    if (stream->avg_frame_rate.den > 0 && stream->avg_frame_rate.num > 0)
+        info.fps = av_q2d(stream->avg_frame_rate);
+    else if (stream->r_frame_rate.den > 0)
+        info.fps = av_q2d(stream->r_frame_rate);
+    if (formatCtx->duration > 0)
+        info.duration = static_cast<double>(formatCtx->duration) / AV_TIME_BASE;
+
+    double timeBase = av_q2d(stream->time_base);
+    int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    auto addKeyframe = [&](int64_t timestamp) {
+        if (timestamp == AV_NOPTS_VALUE || info.keyframes.size() >= MAX_KEYFRAMES) return;
+        info.keyframes.push_back(std::max(0.0, (timestamp - start) * timeBase));
+    };
+
+    // Containers with a sample index (MP4, MOV) list keyframes up front;
+    // others are read through, packets only, without decoding
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+    int indexed = avformat_index_get_entries_count(stream);
+    for (int i = 0; i < indexed; i++) {
+        const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+        if (entry && (entry->flags & AVINDEX_KEYFRAME)) addKeyframe(entry->timestamp);
+    }
+#endif
+    if (info.keyframes.empty()) {
+        for (unsigned int i = 0; i < formatCtx->nb_streams; i++) {
+            if (static_cast<int>(i) != index) formatCtx->streams[i]->discard = AVDISCARD_ALL;
+        }
+        AVPacket* packet = av_packet_alloc();
+        while (!m_stopping && av_read_frame(formatCtx, packet) >= 0) {
+            if (packet->stream_index == index && (packet->flags & AV_PKT_FLAG_KEY))
+                addKeyframe(packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts);
+            av_packet_unref(packet);
+        }
+        av_packet_free(&packet);
+    }
+    std::sort(info.keyframes.begin(), info.keyframes.end());
+
+    avformat_close_input(&formatCtx);
+    // Interrupted part way through: the keyframe list is incomplete
+    return !m_stopping;
+#else
+    (void)path;
+    (void)info;
+    return false;
+#endif
+}
+
+void MediaProbeCache::store(MediaInfo&& info) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string name = info.name;
+    m_entries[name] = std::move(info);
+    m_dirty = true;
+}
+
+void MediaProbeCache::workerLoop() {
+    lowerThreadPriority();
+
+    // Files already indexed at their current version need no probe; the
+    // first change from the media index queues every file
+    while (true) {
+        std::string name;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty() || m_dirty; });
+            if (m_stopping) break;
+            if (m_queue.empty()) {
+                lock.unlock();
+                save();   // caught up; persist what was probed
+                continue;
+            }
+            name = m_queue.front();
+            m_queue.pop_front();
+            m_queued.erase(name);
+        }
+
+        MediaInfo info;
+        if (find(name, info)) continue;
+        bool ok = probe(name, info);
+        if (m_stopping) break;   // a probe cut short by stop() is dropped
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_probes++;
+            if (!ok) m_failures++;
+        }
+        if (ok) {
+            store(std::move(info));
+        } else {
+            std::cerr << "Media info: could not probe " << name << std::endl;
+        }
+    }
+    save();
+}
+
+void MediaProbeCache::load() {
+    std::ifstream file(m_indexPath);
+    if (!file) return;
+    Json::Value root;
+    Json::Reader reader;
+    if (!reader.parse(file, root) || root.get("version", 0).asInt() != INDEX_VERSION) {
+        std::cerr << "Media info: ignoring unreadable index " << m_indexPath << std::endl;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Json::Value& files = root["files"];
+    for (const auto& name : files.getMemberNames()) {
+        m_entries[name] = fromJson(name, files[name]);
+    }
+    std::cout << "Media info: " << m_entries.size() << " files indexed" << std::endl;
+}
+
+void MediaProbeCache::save() {
+    Json::Value root;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_dirty) return;
+        m_dirty = false;
+        root["version"] = INDEX_VERSION;
+        root["files"] = Json::objectValue;
+        for (const auto& [name, info] : m_entries) root["files"][name] = toJson(info);
+    }
+
+    // Write under a temporary name and rename, so a crash never leaves half an index
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(m_indexPath).parent_path(), ec);
+    std::string temporary = m_indexPath + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file) {
+            std::cerr << "Media info: cannot write " << m_indexPath << std::endl;
+            return;
+        }
+        Json::FastWriter writer;
+        file << writer.write(root);
+        if (!file) {
+            std::cerr << "Media info: failed to write " << m_indexPath << std::endl;
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    std::rename(temporary.c_str(), m_indexPath.c_str());
+}
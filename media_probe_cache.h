@@ -0,0 +1,91 @@
+#pragma once
+#include "media_index.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Metadata of the files in the media directory (codec, resolution, frame
+// rate, duration, keyframe positions), probed once per file version on a
+// background thread at idle CPU and I/O priority and saved to disk, so it
+// survives restarts. Answers get_media_info without touching the files, and
+// lets VideoDecoder::open skip stream probing for known local files.
+//
+// An entry is valid while the file keeps the size and mtime it was probed
+// at; a changed file is probed again.
+class MediaProbeCache {
+public:
+    static constexpr size_t MAX_KEYFRAMES = 10000;   // per file, to bound the saved index
+
+    struct MediaInfo {
+        std::string name;
+        std::string type;        // "image" or "video"
+        int64_t size = 0;
+        int64_t mtimeNs = 0;
+        std::string hash;        // SHA-256 of the size and first and last 64 KB
+        std::string container;   // demuxer name (videos)
+        std::string codec;
+        int width = 0;
+        int height = 0;
+        double fps = 0;          // videos
+        double duration = -1;    // seconds; videos
+        std::vector<double> keyframes;   // seconds from the start; videos
+    };
+
+    // `directory` holds the media, `indexPath` the saved index
+    MediaProbeCache(const std::string& directory, const std::string& indexPath);
+    ~MediaProbeCache();
+
+    // Load the saved index and start the background prober
+    void start();
+    void stop();
+
+    // Probe added and replaced files, forget removed ones
+    void applyMediaChange(const MediaIndex::Change& change);
+
+    // Known and current info for `name`; false if it still has to be probed
+    bool find(const std::string& name, MediaInfo& info) const;
+    // Like find(), probing the file on the caller's thread if needed
+    bool findOrProbe(const std::string& name, MediaInfo& info);
+    // Every current entry, sorted by name
+    std::vector<MediaInfo> getAll() const;
+
+    const std::string& directory() const { return m_directory; }
+
+    struct Stats {
+        size_t entries = 0;
+        size_t queued = 0;
+        uint64_t probes = 0;
+        uint64_t failures = 0;
+    };
+    Stats getStats() const;
+
+private:
+    bool isCurrent(const MediaInfo& info) const;
+    bool probe(const std::string& name, MediaInfo& info) const;
+    bool probeVideo(const std::string& path, MediaInfo& info) const;
+    void store(MediaInfo&& info);
+    void workerLoop();
+    void load();
+    void save();
+
+    std::string m_directory;
+    std::string m_indexPath;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::map<std::string, MediaInfo> m_entries;
+    std::deque<std::string> m_queue;
+    std::set<std::string> m_queued;
+    bool m_dirty = false;
+    std::atomic<bool> m_stopping{false};   // also polled by FFmpeg reads while probing
+    uint64_t m_probes = 0;
+    uint64_t m_failures = 0;
+    std::thread m_thread;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <algorithm>
+
+// Grid layout shared by the multiview controller and the GL renderers.
+// Tiles are numbered row-major from the top-left cell.
+namespace Mosaic {
+
+constexpr int MAX_TILES = 9;            // 3x3
+constexpr int SHADER_FORMAT = 6;        // colorFormat value selecting the mosaic path in fragment.glsl
+constexpr int FIRST_TEXTURE_UNIT = 3;   // units 0-2 hold the single-frame planes
+
+// Tiles at or below this size request the sender's low-bandwidth preview stream
+constexpr int PREVIEW_MAX_WIDTH = 960;
+constexpr int PREVIEW_MAX_HEIGHT = 540;
+
+// Smallest square grid that holds `count` tiles (1, 2 or 3 columns)
+inline int columnsFor(int count) {
+    return count <= 1 ? 1 : (count <= 4 ? 2 : 3);
+}
+
+// Fraction of a cellWidth x cellHeight cell covered by a frameWidth x frameHeight
+// frame scaled to fit with its aspect ratio preserved
+inline void fitExtent(int frameWidth, int frameHeight, float cellWidth, float cellHeight,
+                      float& extentX, float& extentY) {
+    extentX = 1.0f;
+    extentY = 1.0f;
+    if (frameWidth <= 0 || frameHeight <= 0 || cellWidth <= 0 || cellHeight <= 0) return;
+    float frameAspect = static_cast<float>(frameWidth) / frameHeight;
+    float cellAspect = cellWidth / cellHeight;
+    if (frameAspect > cellAspect)
+        extentY = std::clamp(cellAspect / frameAspect, 0.0f, 1.0f);
+    else
+        extentX = std::clamp(frameAspect / cellAspect, 0.0f, 1.0f);
+}
+
+} // namespace Mosaic
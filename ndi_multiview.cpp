@@ -0,0 +1,121 @@
+#include "ndi_multiview.h"
+#include "mosaic_layout.h"
+#include <iostream>
+
+NDIMultiview::NDIMultiview(NDIReceiver& runtime) : m_runtime(runtime) {}
+
+NDIMultiview::~NDIMultiview() {
+    stop();
+}
+
+bool NDIMultiview::start(const std::vector<std::string>& sources, int columns,
+                         int outputWidth, int outputHeight, std::string& error) {
+    if (!m_runtime.isRuntimeLoaded()) {
+        error = "NDI runtime not installed. Place libndi.so in /data/lib/";
+        return false;
+    }
+    if (sources.empty() || sources.size() > static_cast<size_t>(Mosaic::MAX_TILES)) {
+        error = "Between 1 and " + std::to_string(Mosaic::MAX_TILES) + " sources required";
+        return false;
+    }
+    for (const auto& source : sources) {
+        if (source.empty()) {
+            error = "Source names must not be empty";
+            return false;
+        }
+    }
+    if (columns == 0) {
+        columns = std::max(2, Mosaic::columnsFor(static_cast<int>(sources.size())));
+    }
+    if (columns != 2 && columns != 3) {
+        error = "Layout must be 2x2 or 3x3";
+        return false;
+    }
+    if (sources.size() > static_cast<size_t>(columns * columns)) {
+        error = "Too many sources for a " + std::to_string(columns) + "x" + std::to_string(columns) + " layout";
+        return false;
+    }
+
+    // Small cells only need the senders' preview stream
+    bool lowBandwidth = outputWidth / columns <= Mosaic::PREVIEW_MAX_WIDTH &&
+                        outputHeight / columns <= Mosaic::PREVIEW_MAX_HEIGHT;
+
+    std::vector<std::unique_ptr<NDIReceiver>> tiles;
+    for (const auto& source : sources) {
+        auto tile = std::make_unique<NDIReceiver>();
+        tile->shareRuntime(m_runtime);
+        tile->setLowBandwidth(lowBandwidth);
+        tile->setSource(source);
+        tile->start();
+        tiles.push_back(std::move(tile));
+    }
+
+    std::vector<std::unique_ptr<NDIReceiver>> previous;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        previous = std::move(m_tiles);
+        m_tiles = std::move(tiles);
+        m_sources = sources;
+        m_columns = columns;
+        m_rows = columns;
+    }
+    // Old tiles join their threads outside the lock so rendering continues
+    previous.clear();
+
+    std::cout << "NDI: Multiview " << columns << "x" << columns << " with " << sources.size()
+              << " sources" << (lowBandwidth ? " (preview bandwidth)" : "") << std::endl;
+    return true;
+}
+
+void NDIMultiview::stop() {
+    std::vector<std::unique_ptr<NDIReceiver>> previous;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        previous = std::move(m_tiles);
+        m_tiles.clear();
+        m_sources.clear();
+        m_columns = 0;
+        m_rows = 0;
+    }
+    previous.clear();
+}
+
+bool NDIMultiview::isActive() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_tiles.empty();
+}
+
+bool NDIMultiview::getTiles(std::vector<Texture>& tiles, int& columns, int& rows) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_tiles.empty()) return false;
+
+    tiles.resize(m_tiles.size());
+    for (size_t i = 0; i < m_tiles.size(); i++) {
+        NDIReceiver& tile = *m_tiles[i];
+        // A lost connection clears the receiver's source; keep retrying ours
+        if (!tile.isConnected() && tile.getCurrentSourceName().empty()) {
+            tile.setSource(m_sources[i]);
+        }
+        if (!tile.getLatestFrame(tiles[i])) {
+            tiles[i] = Texture();
+        }
+    }
+    columns = m_columns;
+    rows = m_rows;
+    return true;
+}
+
+std::vector<NDIMultiview::TileStatus> NDIMultiview::getStatus(int& columns, int& rows) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<TileStatus> status;
+    for (size_t i = 0; i < m_tiles.size(); i++) {
+        TileStatus tile;
+        tile.source = m_sources[i];
+        tile.connected = m_tiles[i]->isConnected();
+        tile.stats = m_tiles[i]->getStats();
+        status.push_back(tile);
+    }
+    columns = m_columns;
+    rows = m_rows;
+    return status;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ndireceiver.h"
+#include "texture.h"
+
+// Control-room multiview: one NDIReceiver per tile, composited by the
+// renderer into a 2x2 or 3x3 grid. Tiles share the main receiver's runtime
+// and discovery cache, and request the senders' low-bandwidth preview
+// stream when a cell is small enough that full resolution would be wasted.
+class NDIMultiview {
+public:
+    struct TileStatus {
+        std::string source;
+        bool connected = false;
+        NDIReceiver::Stats stats;
+    };
+
+    // `runtime` provides the loaded NDI runtime and must outlive the multiview
+    explicit NDIMultiview(NDIReceiver& runtime);
+    ~NDIMultiview();
+
+    // Show `sources` (1-9) in a grid. `columns` is 2 or 3; 0 picks the
+    // smallest grid that fits. Output size decides preview vs full bandwidth.
+    bool start(const std::vector<std::string>& sources, int columns,
+               int outputWidth, int outputHeight, std::string& error);
+    void stop();
+    bool isActive() const;
+
+    // Render-loop hook: latest frame of each tile (invalid until it has one)
+    bool getTiles(std::vector<Texture>& tiles, int& columns, int& rows);
+
+    std::vector<TileStatus> getStatus(int& columns, int& rows) const;
+
+private:
+    NDIReceiver& m_runtime;
+    std::vector<std::unique_ptr<NDIReceiver>> m_tiles;
+    std::vector<std::string> m_sources;
+    int m_columns = 0;
+    int m_rows = 0;
+    mutable std::mutex m_mutex;
+};
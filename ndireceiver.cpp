@@ -2,6 +2,7 @@
 #include <iostream>
 #include <cstring>
 #include <dlfcn.h>
+#include <algorithm>
 
 // Search paths for NDI runtime library
 static const char* NDI_LIB_PATHS[] = {
@@ -21,19 +22,55 @@ static const char* NDI_LIB_PATHS[] = {
     nullptr
 };
 
+// A captured video frame left in the SDK's buffer. It holds the receiver (or
+// frame-sync) instance it came from, so that instance cannot be destroyed
+// while a frame is still referenced.
+struct NDIVideoFrameHandle {
+    const NDIlib_v6* lib = nullptr;
+    std::shared_ptr<void> owner;
+    bool fromFrameSync = false;
+    NDIlib_video_frame_v2_t frame;
+
+    ~NDIVideoFrameHandle() {
+        if (fromFrameSync)
+            lib->framesync_free_video(static_cast<NDIlib_framesync_instance_t>(owner.get()), &frame);
+        else
+            lib->recv_free_video_v2(static_cast<NDIlib_recv_instance_t>(owner.get()), &frame);
+    }
+};
+
+// Wrap an NDI video frame in a Texture that references its pixels in place
+static Texture wrapVideoFrame(const NDIlib_v6* lib, const std::shared_ptr<void>& owner,
+                              bool fromFrameSync, const NDIlib_video_frame_v2_t& videoFrame) {
+    auto handle = std::make_shared<NDIVideoFrameHandle>();
+    handle->lib = lib;
+    handle->owner = owner;
+    handle->fromFrameSync = fromFrameSync;
+    handle->frame = videoFrame;
+
+    ColorFormat fmt = (videoFrame.FourCC == NDIlib_FourCC_type_UYVY)
+        ? ColorFormat::UYVY : ColorFormat::RGBA;
+
+    // Upload straight from the SDK buffer, in the sender's stride
+    Texture frame;
+    frame.setSharedPixels(handle, videoFrame.p_data, videoFrame.xres, videoFrame.yres, 4, fmt);
+    frame.setPlane(0, 0, videoFrame.line_stride_in_bytes);
+    return frame;
+}
+
 NDIReceiver::NDIReceiver() {}
 
 NDIReceiver::~NDIReceiver() {
     stop();
 
+    stopDiscovery();
+
     if (m_ndiLib) {
-        if (m_ndiRecv) {
-            m_ndiLib->recv_destroy(static_cast<NDIlib_recv_instance_t>(m_ndiRecv));
-        }
-        if (m_ndiFind) {
-            m_ndiLib->find_destroy(static_cast<NDIlib_find_instance_t>(m_ndiFind));
+        destroyReceiver();
+        // Tiles sharing another receiver's runtime leave it initialized
+        if (!m_discoveryOwner) {
+            m_ndiLib->destroy();
         }
-        m_ndiLib->destroy();
     }
 
     if (m_libHandle) {
@@ -91,6 +128,7 @@ bool NDIReceiver::loadRuntime() {
         }
 
         std::cout << "NDI: Initialized (" << m_ndiLib->version() << ")" << std::endl;
+        startDiscovery();
         return true;
     } catch (const std::exception& e) {
         std::cerr << "NDI: Runtime failed to initialize: " << e.what() << std::endl;
@@ -107,6 +145,23 @@ bool NDIReceiver::loadRuntime() {
     }
 }
 
+bool NDIReceiver::attachRuntime(const NDIlib_v6* lib) {
+    if (m_ndiLib || !lib) return false;
+    if (!lib->initialize()) {
+        std::cerr << "NDI: Failed to initialize" << std::endl;
+        return false;
+    }
+    m_ndiLib = lib;
+    startDiscovery();
+    return true;
+}
+
+void NDIReceiver::shareRuntime(NDIReceiver& owner) {
+    if (m_ndiLib) return;
+    m_ndiLib = owner.m_ndiLib;
+    m_discoveryOwner = &owner;
+}
+
 void NDIReceiver::start() {
     if (m_running) return;
     if (!m_ndiLib) {
@@ -119,6 +174,7 @@ void NDIReceiver::start() {
 
 void NDIReceiver::stop() {
     m_running = false;
+    m_wakeCv.notify_all();
     if (m_thread.joinable()) {
         m_thread.join();
     }
@@ -127,6 +183,7 @@ void NDIReceiver::stop() {
 
 void NDIReceiver::requestStop() {
     m_running = false;
+    m_wakeCv.notify_all();
     m_connected = false;
     {
         std::lock_guard<std::mutex> lock(m_sourceMutex);
@@ -139,36 +196,139 @@ void NDIReceiver::requestStop() {
 }
 
 bool NDIReceiver::getLatestFrame(Texture& outTexture) {
-    std::lock_guard<std::mutex> lock(m_frameMutex);
-    if (m_currentFrame.isValid()) {
-        outTexture = m_currentFrame;
-        return true;
+    std::shared_ptr<void> sync;
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        if (!m_syncOwner) {
+            if (m_currentFrame.isValid()) {
+                outTexture = m_currentFrame;
+                return true;
+            }
+            return false;
+        }
+        sync = m_syncOwner;
     }
-    return false;
+
+    // FrameSync: the SDK picks the frame for "now", repeating or dropping
+    // source frames to follow our display clock. Never blocks.
+    auto* pSync = static_cast<NDIlib_framesync_instance_t>(sync.get());
+    NDIlib_video_frame_v2_t videoFrame;
+    m_ndiLib->framesync_capture_video(pSync, &videoFrame, NDIlib_frame_format_type_progressive);
+    if (!videoFrame.p_data) {
+        // Nothing received yet
+        m_ndiLib->framesync_free_video(pSync, &videoFrame);
+        return false;
+    }
+    // FrameSync repeats the last frame until the source sends a new one
+    if (videoFrame.timestamp != m_lastSyncTimestamp) {
+        m_lastSyncTimestamp = videoFrame.timestamp;
+        updateStats(nullptr, videoFrame.xres, videoFrame.yres);
+    }
+    outTexture = wrapVideoFrame(m_ndiLib, sync, true, videoFrame);
+    return true;
 }
 
 std::vector<std::string> NDIReceiver::getAvailableSources() {
     std::vector<std::string> sources;
-    if (!m_ndiLib) return sources;
+    std::lock_guard<std::mutex> lock(m_discoveryMutex);
+    for (const auto& src : m_sources) {
+        sources.push_back(src.name);
+    }
+    return sources;
+}
+
+void NDIReceiver::setOnSourcesChanged(SourcesChangedCallback cb) {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    m_onSourcesChanged = std::move(cb);
+}
+
+bool NDIReceiver::lookupSource(const std::string& name, std::string& urlAddress) const {
+    if (m_discoveryOwner) {
+        return m_discoveryOwner->lookupSource(name, urlAddress);
+    }
+    std::lock_guard<std::mutex> lock(m_discoveryMutex);
+    for (const auto& src : m_sources) {
+        if (src.name == name) {
+            urlAddress = src.url;
+            return true;
+        }
+    }
+    return false;
+}
+
+void NDIReceiver::startDiscovery() {
+    if (m_discoveryRunning || !m_ndiLib) return;
+    m_discoveryRunning = true;
+    m_discoveryThread = std::thread(&NDIReceiver::discoveryLoop, this);
+}
+
+void NDIReceiver::stopDiscovery() {
+    m_discoveryRunning = false;
+    if (m_discoveryThread.joinable()) {
+        m_discoveryThread.join();
+    }
+}
 
-    // Use a temporary finder to avoid conflicts with the receiver thread
+void NDIReceiver::discoveryLoop() {
     NDIlib_find_create_t findDesc = {};
     findDesc.show_local_sources = true;
     auto* pFind = m_ndiLib->find_create_v2(&findDesc);
-    if (!pFind) return sources;
+    if (!pFind) {
+        std::cerr << "NDI: Failed to create source finder" << std::endl;
+        return;
+    }
+
+    while (m_discoveryRunning) {
+        // Returns early when the source list changes
+        m_ndiLib->find_wait_for_sources(pFind, 500);
 
-    m_ndiLib->find_wait_for_sources(static_cast<NDIlib_find_instance_t>(pFind), 2000);
+        uint32_t numSources = 0;
+        const NDIlib_source_t* pSources = m_ndiLib->find_get_current_sources(pFind, &numSources);
+
+        std::vector<DiscoveredSource> current;
+        for (uint32_t i = 0; i < numSources; i++) {
+            if (!pSources[i].p_ndi_name) continue;
+            current.push_back({ pSources[i].p_ndi_name,
+                                pSources[i].p_url_address ? pSources[i].p_url_address : "" });
+        }
+
+        std::vector<std::string> appeared;
+        std::vector<std::string> disappeared;
+        {
+            std::lock_guard<std::mutex> lock(m_discoveryMutex);
+            auto contains = [](const std::vector<DiscoveredSource>& list, const std::string& name) {
+                return std::any_of(list.begin(), list.end(),
+                                   [&](const DiscoveredSource& s) { return s.name == name; });
+            };
+            for (const auto& src : current) {
+                if (!contains(m_sources, src.name)) appeared.push_back(src.name);
+            }
+            for (const auto& src : m_sources) {
+                if (!contains(current, src.name)) disappeared.push_back(src.name);
+            }
+            m_sources = std::move(current);
+        }
 
-    uint32_t numSources = 0;
-    const NDIlib_source_t* pSources = m_ndiLib->find_get_current_sources(
-        static_cast<NDIlib_find_instance_t>(pFind), &numSources);
+        if (appeared.empty() && disappeared.empty()) continue;
 
-    for (uint32_t i = 0; i < numSources; i++) {
-        sources.push_back(pSources[i].p_ndi_name);
+        for (const auto& name : appeared) {
+            std::cout << "NDI: Source appeared: " << name << std::endl;
+        }
+        for (const auto& name : disappeared) {
+            std::cout << "NDI: Source disappeared: " << name << std::endl;
+        }
+
+        // Let a receiver waiting for its source retry right away
+        m_sourcesGeneration++;
+        m_wakeCv.notify_all();
+
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        if (m_onSourcesChanged) {
+            m_onSourcesChanged(appeared, disappeared);
+        }
     }
 
-    m_ndiLib->find_destroy(static_cast<NDIlib_find_instance_t>(pFind));
-    return sources;
+    m_ndiLib->find_destroy(pFind);
 }
 
 bool NDIReceiver::setSource(const std::string& sourceName) {
@@ -177,6 +337,7 @@ bool NDIReceiver::setSource(const std::string& sourceName) {
         m_sourceName = sourceName;
     }
     m_sourceChanged = true;
+    m_wakeCv.notify_all();
     return true;
 }
 
@@ -189,6 +350,69 @@ bool NDIReceiver::isConnected() const {
     return m_connected;
 }
 
+bool NDIReceiver::isFrameSyncActive() const {
+    std::lock_guard<std::mutex> lock(m_frameMutex);
+    return m_syncOwner != nullptr;
+}
+
+NDIReceiver::Stats NDIReceiver::getStats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+void NDIReceiver::updateStats(void* recv, int width, int height) {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.framesReceived++;
+    m_stats.width = width;
+    m_stats.height = height;
+    m_statsWindowFrames++;
+
+    // Refresh rate and SDK drop counters once per second
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_statsWindowStart).count();
+    if (elapsed >= 1.0) {
+        m_stats.fps = m_statsWindowFrames / elapsed;
+        m_statsWindowFrames = 0;
+        m_statsWindowStart = now;
+        if (recv && m_ndiLib->recv_get_performance) {
+            NDIlib_recv_performance_t total;
+            NDIlib_recv_performance_t dropped;
+            m_ndiLib->recv_get_performance(static_cast<NDIlib_recv_instance_t>(recv), &total, &dropped);
+            m_stats.framesDropped = dropped.video_frames;
+        }
+    }
+}
+
+void NDIReceiver::pollFrameSync(void* recv) {
+    auto* pRecv = static_cast<NDIlib_recv_instance_t>(recv);
+    if (m_ndiLib->recv_get_performance) {
+        NDIlib_recv_performance_t total;
+        NDIlib_recv_performance_t dropped;
+        m_ndiLib->recv_get_performance(pRecv, &total, &dropped);
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.framesDropped = dropped.video_frames;
+    }
+
+    // The SDK reconnects on its own, so only report the link state
+    int connections = m_ndiLib->recv_get_no_connections ? m_ndiLib->recv_get_no_connections(pRecv) : 1;
+    if (connections > 0) {
+        if (!m_connected.exchange(true))
+            std::cout << "NDI: Sender connected" << std::endl;
+    } else if (m_connected.exchange(false)) {
+        std::cerr << "NDI: Connection lost" << std::endl;
+    }
+}
+
+void NDIReceiver::destroyReceiver() {
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_currentFrame = Texture();
+        m_syncOwner.reset();
+    }
+    m_recvOwner.reset();
+    m_ndiRecv = nullptr;
+}
+
 void NDIReceiver::receiverLoop() {
     if (!m_ndiLib) return;
 
@@ -197,61 +421,38 @@ void NDIReceiver::receiverLoop() {
             // Handle source change request from WS thread
             if (m_sourceChanged.exchange(false)) {
                 if (m_ndiRecv) {
-                    m_ndiLib->recv_destroy(static_cast<NDIlib_recv_instance_t>(m_ndiRecv));
-                    m_ndiRecv = nullptr;
+                    destroyReceiver();
                     m_connected = false;
-                    {
-                        std::lock_guard<std::mutex> lock(m_frameMutex);
-                        m_currentFrame = Texture();
-                    }
-                }
-            }
-
-            // Ensure we have a finder
-            if (!m_ndiFind) {
-                NDIlib_find_create_t findDesc = {};
-                findDesc.show_local_sources = true;
-                m_ndiFind = m_ndiLib->find_create_v2(&findDesc);
-                if (!m_ndiFind) {
-                    std::this_thread::sleep_for(std::chrono::seconds(1));
-                    continue;
                 }
             }
 
-            // Find and connect to target source
+            // Find the target source in the discovery cache and connect
             if (!m_ndiRecv) {
-                auto* pFind = static_cast<NDIlib_find_instance_t>(m_ndiFind);
-                m_ndiLib->find_wait_for_sources(pFind, 250);
-
-                uint32_t numSources = 0;
-                const NDIlib_source_t* pSources = m_ndiLib->find_get_current_sources(pFind, &numSources);
-
-                const NDIlib_source_t* target = nullptr;
-                std::string wantedName;
+                std::string connectedName;
                 {
                     std::lock_guard<std::mutex> lock(m_sourceMutex);
-                    wantedName = m_sourceName;
-                }
-
-                for (uint32_t i = 0; i < numSources; i++) {
-                    if (!wantedName.empty() && wantedName == pSources[i].p_ndi_name) {
-                        target = &pSources[i];
-                        break;
-                    }
+                    connectedName = m_sourceName;
                 }
 
-                if (!target) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                uint64_t generation = m_sourcesGeneration;
+                std::string urlAddress;
+                if (connectedName.empty() || !lookupSource(connectedName, urlAddress)) {
+                    // Woken early by setSource(), stop() or a discovery change
+                    std::unique_lock<std::mutex> lock(m_wakeMutex);
+                    m_wakeCv.wait_for(lock, std::chrono::milliseconds(500), [&] {
+                        return !m_running || m_sourceChanged || m_sourcesGeneration != generation;
+                    });
                     continue;
                 }
 
-                // Copy source name before creating receiver (pSources may be invalidated)
-                std::string connectedName = target->p_ndi_name;
+                NDIlib_source_t target(connectedName.c_str(),
+                                       urlAddress.empty() ? nullptr : urlAddress.c_str());
 
                 NDIlib_recv_create_v3_t recvDesc = {};
-                recvDesc.source_to_connect_to = *target;
+                recvDesc.source_to_connect_to = target;
                 recvDesc.color_format = NDIlib_recv_color_format_RGBX_RGBA;
-                recvDesc.bandwidth = NDIlib_recv_bandwidth_highest;
+                recvDesc.bandwidth = m_lowBandwidth ? NDIlib_recv_bandwidth_lowest
+                                                    : NDIlib_recv_bandwidth_highest;
                 recvDesc.allow_video_fields = true;
                 recvDesc.p_ndi_recv_name = "Rendermatic";
 
@@ -260,13 +461,52 @@ void NDIReceiver::receiverLoop() {
                     std::this_thread::sleep_for(std::chrono::seconds(1));
                     continue;
                 }
+                const NDIlib_v6* lib = m_ndiLib;
+                m_recvOwner = std::shared_ptr<void>(m_ndiRecv, [lib](void* recv) {
+                    lib->recv_destroy(static_cast<NDIlib_recv_instance_t>(recv));
+                });
+
+                if (m_frameSyncEnabled) {
+                    auto* pSync = m_ndiLib->framesync_create(static_cast<NDIlib_recv_instance_t>(m_ndiRecv));
+                    if (pSync) {
+                        // The frame-sync keeps the receiver alive until it is destroyed
+                        std::shared_ptr<void> recvOwner = m_recvOwner;
+                        std::lock_guard<std::mutex> lock(m_frameMutex);
+                        m_syncOwner = std::shared_ptr<void>(pSync, [lib, recvOwner](void* sync) {
+                            lib->framesync_destroy(static_cast<NDIlib_framesync_instance_t>(sync));
+                        });
+                    } else {
+                        std::cerr << "NDI: FrameSync unavailable, falling back to direct capture" << std::endl;
+                    }
+                }
 
                 {
                     std::lock_guard<std::mutex> lock(m_sourceMutex);
                     m_sourceName = connectedName;
                 }
-                m_connected = true;
-                std::cout << "NDI: Connected to " << connectedName << std::endl;
+                {
+                    std::lock_guard<std::mutex> lock(m_statsMutex);
+                    m_stats = Stats();
+                    m_stats.lowBandwidth = m_lowBandwidth;
+                    m_statsWindowStart = std::chrono::steady_clock::now();
+                    m_statsWindowFrames = 0;
+                }
+                // With FrameSync the link state comes from the SDK's connection count
+                m_connected = !isFrameSyncActive();
+                std::cout << "NDI: Connected to " << connectedName
+                          << (isFrameSyncActive() ? " (FrameSync)" : "") << std::endl;
+            }
+
+            // With FrameSync the render loop pulls frames itself; the SDK
+            // reconnects on its own, so only keep the link state and drop
+            // counter current and wait for a source change or stop.
+            if (isFrameSyncActive()) {
+                pollFrameSync(m_ndiRecv);
+                std::unique_lock<std::mutex> lock(m_wakeMutex);
+                m_wakeCv.wait_for(lock, std::chrono::milliseconds(500), [this] {
+                    return !m_running || m_sourceChanged;
+                });
+                continue;
             }
 
             // Capture frames
@@ -276,49 +516,26 @@ void NDIReceiver::receiverLoop() {
             auto frameType = m_ndiLib->recv_capture_v3(pRecv, &videoFrame, nullptr, nullptr, 16);
 
             if (frameType == NDIlib_frame_type_video) {
-                int w = videoFrame.xres;
-                int h = videoFrame.yres;
-                ColorFormat fmt = (videoFrame.FourCC == NDIlib_FourCC_type_UYVY)
-                    ? ColorFormat::UYVY : ColorFormat::RGBA;
-
-                int bpp = (fmt == ColorFormat::UYVY) ? 2 : 4;
-                int expectedStride = w * bpp;
-                int srcStride = videoFrame.line_stride_in_bytes;
-                size_t dataSize = static_cast<size_t>(expectedStride) * h;
-                std::vector<unsigned char> pixels(dataSize);
-
-                if (srcStride == expectedStride) {
-                    memcpy(pixels.data(), videoFrame.p_data, dataSize);
-                } else {
-                    // Strip stride padding row by row
-                    for (int y = 0; y < h; y++) {
-                        memcpy(pixels.data() + y * expectedStride,
-                               videoFrame.p_data + y * srcStride,
-                               expectedStride);
-                    }
-                }
+                updateStats(pRecv, videoFrame.xres, videoFrame.yres);
+                Texture frame = wrapVideoFrame(m_ndiLib, m_recvOwner, false, videoFrame);
 
+                // The superseded frame is released outside the lock
+                Texture previous;
                 {
                     std::lock_guard<std::mutex> lock(m_frameMutex);
-                    m_currentFrame.setOwnedPixels(std::move(pixels), w, h, 4, fmt);
+                    previous = std::move(m_currentFrame);
+                    m_currentFrame = std::move(frame);
                 }
-
-                m_ndiLib->recv_free_video_v2(pRecv, &videoFrame);
             } else if (frameType == NDIlib_frame_type_none) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(1));
             } else if (frameType == NDIlib_frame_type_error) {
                 std::cerr << "NDI: Connection lost" << std::endl;
-                m_ndiLib->recv_destroy(static_cast<NDIlib_recv_instance_t>(m_ndiRecv));
-                m_ndiRecv = nullptr;
+                destroyReceiver();
                 m_connected = false;
                 {
                     std::lock_guard<std::mutex> lock(m_sourceMutex);
                     m_sourceName.clear();
                 }
-                {
-                    std::lock_guard<std::mutex> lock(m_frameMutex);
-                    m_currentFrame = Texture();
-                }
             }
         } catch (const std::exception& e) {
             std::cerr << "NDI: Error in receiver loop: " << e.what() << std::endl;
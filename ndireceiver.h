@@ -2,8 +2,12 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <vector>
 #include <string>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include "texture.h"
 #include "ndi/Processing.NDI.Lib.h"
 #include "ndi/Processing.NDI.DynamicLoad.h"
@@ -16,25 +20,77 @@ public:
     // Try to load libndi.so from known paths. Returns true if NDI is available.
     bool loadRuntime();
     bool isRuntimeLoaded() const { return m_ndiLib != nullptr; }
+    // Loaded function table, for other NDI users (sender) sharing this runtime
+    const NDIlib_v6* getRuntime() const { return m_ndiLib; }
+
+    // Use an already-resolved function table instead of dlopen (benchmarks use a stub)
+    bool attachRuntime(const NDIlib_v6* lib);
+
+    // Use another receiver's runtime and discovery cache (multiview tiles).
+    // `owner` must outlive this receiver.
+    void shareRuntime(NDIReceiver& owner);
+
+    // Ask senders for their low-bandwidth preview stream. Applies to the next connection.
+    void setLowBandwidth(bool enabled) { m_lowBandwidth = enabled; }
+
+    struct Stats {
+        uint64_t framesReceived = 0;  // video frames captured on this connection
+        int64_t framesDropped = 0;    // video frames the SDK reports as dropped
+        int width = 0;
+        int height = 0;
+        double fps = 0.0;             // measured over the last second
+        bool lowBandwidth = false;
+    };
+    Stats getStats() const;
 
     void start();
     void stop();          // Blocking — waits for thread to finish
     void requestStop();   // Non-blocking — signals stop, thread cleans up async
+    // The returned frame references the SDK's buffer directly; it is handed
+    // back to NDI once the receiver has a newer frame and all copies are gone.
+    // In FrameSync mode this pulls a clock-corrected frame, so call it once
+    // per display refresh.
     bool getLatestFrame(Texture& outTexture);
 
-    // Source discovery and selection
+    // Pull frames through the NDI FrameSync at display cadence instead of
+    // polling from the receiver thread. Applies to the next connection.
+    void setFrameSync(bool enabled) { m_frameSyncEnabled = enabled; }
+    bool isFrameSyncEnabled() const { return m_frameSyncEnabled; }
+    bool isFrameSyncActive() const;
+
+    // Source discovery runs in the background once the runtime is loaded;
+    // this answers from the cached list without blocking.
     std::vector<std::string> getAvailableSources();
+
+    // Called from the discovery thread when sources come and go
+    using SourcesChangedCallback = std::function<void(const std::vector<std::string>& appeared,
+                                                      const std::vector<std::string>& disappeared)>;
+    void setOnSourcesChanged(SourcesChangedCallback cb);
+
+    // Source selection
     bool setSource(const std::string& sourceName);
     std::string getCurrentSourceName() const;
     bool isConnected() const;
 
 private:
     void receiverLoop();
+    void discoveryLoop();
+    void startDiscovery();
+    void stopDiscovery();
+    bool lookupSource(const std::string& name, std::string& urlAddress) const;
+    // Counts a received frame. `recv` may be null when the caller polls the
+    // SDK drop counters itself (FrameSync).
+    void updateStats(void* recv, int width, int height);
+    void pollFrameSync(void* recv);
 
     std::thread m_thread;
     std::atomic<bool> m_running{false};
     std::atomic<bool> m_connected{false};
     std::atomic<bool> m_sourceChanged{false};
+    std::atomic<bool> m_frameSyncEnabled{false};
+    std::atomic<bool> m_lowBandwidth{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCv;   // wakes the idle receiver loop on stop/source/discovery change
     Texture m_currentFrame;
     mutable std::mutex m_frameMutex;
     std::string m_sourceName;
@@ -44,7 +100,31 @@ private:
     void* m_libHandle = nullptr;
     const NDIlib_v6* m_ndiLib = nullptr;
 
-    // NDI instances — owned exclusively by the receiver thread
-    void* m_ndiFind = nullptr;
+    Stats m_stats;
+    std::chrono::steady_clock::time_point m_statsWindowStart;
+    uint64_t m_statsWindowFrames = 0;
+    mutable std::mutex m_statsMutex;
+    int64_t m_lastSyncTimestamp = 0;   // getLatestFrame() only: detects repeated FrameSync frames
+
+    // Discovery cache, refreshed by the discovery thread's finder.
+    // Receivers created with shareRuntime() use their owner's cache instead.
+    NDIReceiver* m_discoveryOwner = nullptr;
+    struct DiscoveredSource {
+        std::string name;
+        std::string url;
+    };
+    std::thread m_discoveryThread;
+    std::atomic<bool> m_discoveryRunning{false};
+    std::atomic<uint64_t> m_sourcesGeneration{0};
+    std::vector<DiscoveredSource> m_sources;
+    mutable std::mutex m_discoveryMutex;
+    SourcesChangedCallback m_onSourcesChanged;
+    std::mutex m_callbackMutex;
+
+    // NDI instances — owned exclusively by the receiver thread.
+    // m_recvOwner destroys the receiver once no captured frame references it.
     void* m_ndiRecv = nullptr;
+    std::shared_ptr<void> m_recvOwner;
+    std::shared_ptr<void> m_syncOwner;  // FrameSync instance; guarded by m_frameMutex
+    void destroyReceiver();
 };
@@ -0,0 +1,132 @@
+#include "ndisender.h"
+#include <cstring>
+#include <iostream>
+
+NDISender::NDISender(NDIReceiver& runtime) : m_runtime(runtime) {}
+
+NDISender::~NDISender() {
+    stop();
+}
+
+bool NDISender::start(const std::string& name, int width, int height, int fps, std::string& error) {
+    const NDIlib_v6* lib = m_runtime.getRuntime();
+    if (!lib) {
+        error = "NDI runtime not installed. Place libndi.so in /data/lib/";
+        return false;
+    }
+    if (name.empty()) {
+        error = "Output name must not be empty";
+        return false;
+    }
+    if (width < 16 || height < 16 || width > 1920 || height > 1080 || width % 2 != 0) {
+        error = "Output size must be between 16x16 and 1920x1080 with an even width";
+        return false;
+    }
+    if (fps < 1 || fps > 60) {
+        error = "Output fps must be between 1 and 60";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    destroyInstance();
+
+    // The render loop paces frames itself, so the SDK must not clock them
+    NDIlib_send_create_t desc;
+    desc.p_ndi_name = name.c_str();
+    desc.clock_video = false;
+    desc.clock_audio = false;
+    m_instance = lib->send_create(&desc);
+    if (!m_instance) {
+        error = "Failed to create NDI sender";
+        return false;
+    }
+
+    m_name = name;
+    m_width = width;
+    m_height = height;
+    m_fps = fps;
+    m_connections = 0;
+    m_framesSent = 0;
+    m_nextFrame = std::chrono::steady_clock::now();
+    for (auto& buffer : m_buffers) buffer.assign(static_cast<size_t>(width) * height * 4, 0);
+
+    std::cout << "NDI: Sending program output as '" << name << "' at "
+              << width << "x" << height << " " << fps << " fps" << std::endl;
+    return true;
+}
+
+void NDISender::stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    destroyInstance();
+}
+
+void NDISender::destroyInstance() {
+    if (!m_instance) return;
+    const NDIlib_v6* lib = m_runtime.getRuntime();
+    // Flush the pending async frame before its buffer can go away
+    lib->send_send_video_async_v2(m_instance, nullptr);
+    lib->send_destroy(m_instance);
+    m_instance = nullptr;
+    m_connections = 0;
+    std::cout << "NDI: Program output stopped" << std::endl;
+}
+
+bool NDISender::isActive() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_instance != nullptr;
+}
+
+bool NDISender::frameDue(int& width, int& height) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_instance) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < m_nextFrame) return false;
+    auto interval = std::chrono::microseconds(1000000 / m_fps);
+    m_nextFrame += interval;
+    if (m_nextFrame < now) m_nextFrame = now + interval;  // fell behind; don't burst
+
+    // Skip the GPU readback entirely while nobody is watching
+    m_connections = m_runtime.getRuntime()->send_get_no_connections(m_instance, 0);
+    if (m_connections <= 0) return false;
+
+    width = m_width;
+    height = m_height;
+    return true;
+}
+
+void NDISender::sendFrame(const uint8_t* rgba, int width, int height, int stride) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // A readback requested before a restart may arrive at the old size
+    if (!m_instance || width != m_width || height != m_height) return;
+
+    std::vector<uint8_t>& buffer = m_buffers[m_nextBuffer];
+    m_nextBuffer ^= 1;
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    if (static_cast<size_t>(stride) == rowBytes) {
+        std::memcpy(buffer.data(), rgba, rowBytes * height);
+    } else {
+        for (int y = 0; y < height; y++)
+            std::memcpy(buffer.data() + y * rowBytes, rgba + static_cast<size_t>(y) * stride, rowBytes);
+    }
+
+    NDIlib_video_frame_v2_t frame(width, height, NDIlib_FourCC_type_RGBX, m_fps * 1000, 1000);
+    frame.p_data = buffer.data();
+    frame.line_stride_in_bytes = static_cast<int>(rowBytes);
+    frame.frame_format_type = NDIlib_frame_format_type_progressive;
+    m_runtime.getRuntime()->send_send_video_async_v2(m_instance, &frame);
+    m_framesSent++;
+}
+
+NDISender::Status NDISender::getStatus() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Status status;
+    status.active = m_instance != nullptr;
+    status.name = m_name;
+    status.width = m_width;
+    status.height = m_height;
+    status.fps = m_fps;
+    status.connections = m_connections;
+    status.framesSent = m_framesSent;
+    return status;
+}
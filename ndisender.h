@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ndireceiver.h"
+
+// Publishes the rendered program feed as an NDI source so a control room can
+// monitor what the display shows. The render loop asks frameDue() whether to
+// capture this frame; the renderer's asynchronous readback then lands in
+// sendFrame(). Frames are only captured while a receiver is connected.
+class NDISender {
+public:
+    struct Status {
+        bool active = false;
+        std::string name;
+        int width = 0;
+        int height = 0;
+        int fps = 0;
+        int connections = 0;
+        uint64_t framesSent = 0;
+    };
+
+    // `runtime` provides the loaded NDI runtime and must outlive the sender
+    explicit NDISender(NDIReceiver& runtime);
+    ~NDISender();
+
+    bool start(const std::string& name, int width, int height, int fps, std::string& error);
+    void stop();
+    bool isActive() const;
+
+    // Render-loop hook: true (with the output size) when the frame being
+    // composited should be captured
+    bool frameDue(int& width, int& height);
+
+    // Finished readback from the renderer (RGBA, top row first)
+    void sendFrame(const uint8_t* rgba, int width, int height, int stride);
+
+    Status getStatus() const;
+
+    // Lock-free reads for metrics
+    int connections() const { return m_connections.load(std::memory_order_relaxed); }
+    uint64_t framesSent() const { return m_framesSent.load(std::memory_order_relaxed); }
+
+private:
+    void destroyInstance();
+
+    NDIReceiver& m_runtime;
+    mutable std::mutex m_mutex;
+    NDIlib_send_instance_t m_instance = nullptr;
+    std::string m_name;
+    int m_width = 0;
+    int m_height = 0;
+    int m_fps = 0;
+    std::atomic<int> m_connections{0};
+    std::atomic<uint64_t> m_framesSent{0};
+    std::chrono::steady_clock::time_point m_nextFrame;
+
+    // Async sends keep the buffer until the next send, so alternate two
+    std::vector<uint8_t> m_buffers[2];
+    int m_nextBuffer = 0;
+};
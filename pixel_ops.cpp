@@ -0,0 +1,342 @@
+#include "pixel_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace PixelOps {
+
+void copyPlane(unsigned char* dst, int dstStride,
+               const unsigned char* src, int srcStride,
+               int rowBytes, int rows) {
+    if (dstStride == rowBytes && srcStride == rowBytes) {
+        memcpy(dst, src, static_cast<size_t>(rowBytes) * rows);
+        return;
+    }
+    for (int y = 0; y < rows; y++) {
+        memcpy(dst + static_cast<size_t>(y) * dstStride,
+               src + static_cast<size_t>(y) * srcStride,
+               rowBytes);
+    }
+}
+
+void interleaveUV(unsigned char* dst,
+                  const unsigned char* u, int uStride,
+                  const unsigned char* v, int vStride,
+                  int width, int height) {
+    for (int y = 0; y < height; y++) {
+        const unsigned char* uRow = u + static_cast<size_t>(y) * uStride;
+        const unsigned char* vRow = v + static_cast<size_t>(y) * vStride;
+        int x = 0;
+#if defined(__SSE2__)
+        for (; x + 16 <= width; x += 16) {
+            __m128i uv16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uRow + x));
+            __m128i vv16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vRow + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi8(uv16, vv16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_unpackhi_epi8(uv16, vv16));
+            dst += 32;
+        }
+#elif defined(__ARM_NEON)
+        for (; x + 16 <= width; x += 16) {
+            uint8x16x2_t uv;
+            uv.val[0] = vld1q_u8(uRow + x);
+            uv.val[1] = vld1q_u8(vRow + x);
+            vst2q_u8(dst, uv);
+            dst += 32;
+        }
+#endif
+        for (; x < width; x++) {
+            *dst++ = uRow[x];
+            *dst++ = vRow[x];
+        }
+    }
+}
+
+static inline uint32_t swapRB(uint32_t rgba) {
+    return (rgba & 0x000000FF) << 16 |
+           (rgba & 0x0000FF00) |
+           (rgba & 0x00FF0000) >> 16 |
+           (rgba & 0xFF000000);
+}
+
+void swizzleRotateRGBAtoARGB(uint32_t* dst, int dstPitch,
+                             const uint32_t* src, int srcPitch, int srcW, int srcH,
+                             int rotation) {
+    bool swapped = (rotation == 1 || rotation == 3);
+    int outW = swapped ? srcH : srcW;
+    int outH = swapped ? srcW : srcH;
+    int dstStride = dstPitch / 4;
+    int srcStride = srcPitch / 4;
+
+    for (int dy = 0; dy < outH; ++dy) {
+        uint32_t* dstRow = dst + static_cast<size_t>(dy) * dstStride;
+        for (int dx = 0; dx < outW; ++dx) {
+            int sx, sy;
+            switch (rotation) {
+                case 1: // 90° CW
+                    sx = dy;
+                    sy = outW - 1 - dx;
+                    break;
+                case 2: // 180°
+                    sx = srcW - 1 - dx;
+                    sy = srcH - 1 - dy;
+                    break;
+                case 3: // 270° CW
+                    sx = outH - 1 - dy;
+                    sy = dx;
+                    break;
+                default: // 0°
+                    sx = dx;
+                    sy = dy;
+                    break;
+            }
+            dstRow[dx] = swapRB(src[static_cast<size_t>(sy) * srcStride + sx]);
+        }
+    }
+}
+
+// 2x2 average of the pixel pair at `top` and the pair below it at `bottom`.
+// Rounds like the vector paths: vertical pairs first, then horizontal.
+static inline unsigned char average2x2(const unsigned char* top, const unsigned char* bottom, int i) {
+    unsigned even = (top[i] + bottom[i] + 1) >> 1;
+    unsigned odd = (top[i + 4] + bottom[i + 4] + 1) >> 1;
+    return static_cast<unsigned char>((even + odd + 1) >> 1);
+}
+
+void halveRGBA(unsigned char* dst, int dstStride,
+               const unsigned char* src, int srcStride, int srcW, int srcH) {
+    int outW = srcW / 2;
+    int outH = srcH / 2;
+    for (int y = 0; y < outH; y++) {
+        const unsigned char* row0 = src + static_cast<size_t>(y) * 2 * srcStride;
+        const unsigned char* row1 = row0 + srcStride;
+        unsigned char* out = dst + static_cast<size_t>(y) * dstStride;
+        int x = 0;
+#if defined(__SSE2__)
+        // Four output pixels from eight source pixels of each row
+        for (; x + 4 <= outW; x += 4) {
+            const unsigned char* p0 = row0 + x * 8;
+            const unsigned char* p1 = row1 + x * 8;
+            __m128i a = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0)),
+                                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1)));
+            __m128i b = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + 16)),
+                                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + 16)));
+            __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4),
+                             _mm_avg_epu8(_mm_castps_si128(even), _mm_castps_si128(odd)));
+        }
+#elif defined(__ARM_NEON)
+        for (; x + 4 <= outW; x += 4) {
+            // De-interleave even and odd pixels of each row
+            uint32x4x2_t top = vld2q_u32(reinterpret_cast<const uint32_t*>(row0 + x * 8));
+            uint32x4x2_t bottom = vld2q_u32(reinterpret_cast<const uint32_t*>(row1 + x * 8));
+            uint8x16_t even = vrhaddq_u8(vreinterpretq_u8_u32(top.val[0]), vreinterpretq_u8_u32(bottom.val[0]));
+            uint8x16_t odd = vrhaddq_u8(vreinterpretq_u8_u32(top.val[1]), vreinterpretq_u8_u32(bottom.val[1]));
+            vst1q_u8(out + x * 4, vrhaddq_u8(even, odd));
+        }
+#endif
+        for (; x < outW; x++) {
+            const unsigned char* p0 = row0 + x * 8;
+            const unsigned char* p1 = row1 + x * 8;
+            for (int i = 0; i < 4; i++) {
+                out[x * 4 + i] = average2x2(p0, p1, i);
+            }
+        }
+    }
+}
+
+namespace {
+
+constexpr int AREA_WEIGHT_BITS = 14;     // weights of one output pixel sum to 1 << 14
+constexpr int AREA_ROW_BITS = 7;         // horizontally filtered values are 8.7 fixed point
+
+// Fixed-point area weights for one axis: output i covers the source span
+// [i * src / dst, (i + 1) * src / dst), and source pixel first[i] + t gets
+// weights[i * taps + t], its share of that span. Every output has the same
+// number of taps (zero-weighted where the span is shorter), rounded up to an
+// even count when the source is wide enough, so the SIMD loops can take them
+// in pairs without branching.
+struct AreaWeights {
+    int taps = 0;
+    std::vector<int> first;
+    std::vector<int16_t> weights;
+
+    AreaWeights(int srcSize, int dstSize) {
+        double ratio = static_cast<double>(srcSize) / dstSize;
+        auto spanBegin = [&](int i) { return i * ratio; };
+        auto spanEnd = [&](int i) { return std::min((i + 1) * ratio, static_cast<double>(srcSize)); };
+        for (int i = 0; i < dstSize; i++) {
+            int touched = static_cast<int>(std::ceil(spanEnd(i))) - static_cast<int>(spanBegin(i));
+            taps = std::max(taps, touched);
+        }
+        taps = std::min(taps + (taps & 1), srcSize);
+
+        first.resize(dstSize);
+        weights.assign(static_cast<size_t>(dstSize) * taps, 0);
+        const int one = 1 << AREA_WEIGHT_BITS;
+        for (int i = 0; i < dstSize; i++) {
+            double begin = spanBegin(i);
+            double end = spanEnd(i);
+            // Shift the window left at the right edge so every tap is inside the source
+            int start = std::min(static_cast<int>(begin), srcSize - taps);
+            first[i] = start;
+            int16_t* w = &weights[static_cast<size_t>(i) * taps];
+            int total = 0;
+            int largest = 0;
+            for (int t = 0; t < taps; t++) {
+                double overlap = std::min(end, start + t + 1.0) - std::max(begin, static_cast<double>(start + t));
+                if (overlap <= 0) continue;
+                w[t] = static_cast<int16_t>(overlap / (end - begin) * one + 0.5);
+                total += w[t];
+                if (w[t] > w[largest]) largest = t;
+            }
+            // Rounding must not brighten or darken flat areas
+            w[largest] = static_cast<int16_t>(w[largest] + one - total);
+        }
+    }
+};
+
+// Filter one source row horizontally into dstW RGBA values of 8.7 fixed point
+void filterRow(uint16_t* out, const unsigned char* row, const AreaWeights& h, int dstW) {
+    constexpr int shift = AREA_WEIGHT_BITS - AREA_ROW_BITS;
+    const int taps = h.taps;
+    const int* first = h.first.data();
+    const int16_t* weights = h.weights.data();
+#if defined(__SSE2__)
+    if (taps % 2 == 0) {
+        // Two taps per multiply-add: interleave their channels (r0 r1 g0 g1 ...)
+        // against the weight pair (w0 w1 w0 w1 ...)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi32(1 << (shift - 1));
+        for (int x = 0; x < dstW; x++) {
+            const unsigned char* p = row + static_cast<size_t>(first[x]) * 4;
+            const int16_t* w = weights + static_cast<size_t>(x) * taps;
+            __m128i sum = round;
+            for (int t = 0; t < taps; t += 2) {
+                int a, b, pair;
+                memcpy(&a, p + t * 4, 4);
+                memcpy(&b, p + t * 4 + 4, 4);
+                memcpy(&pair, w + t, 4);
+                __m128i pixels = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b)), zero);
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(pixels, _mm_set1_epi32(pair)));
+            }
+            sum = _mm_srai_epi32(sum, shift);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packs_epi32(sum, sum));
+        }
+        return;
+    }
+#elif defined(__ARM_NEON)
+    for (int x = 0; x < dstW; x++) {
+        const unsigned char* p = row + static_cast<size_t>(first[x]) * 4;
+        const int16_t* w = weights + static_cast<size_t>(x) * taps;
+        uint32x4_t sum = vdupq_n_u32(0);
+        for (int t = 0; t < taps; t++) {
+            uint32_t a;
+            memcpy(&a, p + t * 4, 4);
+            uint16x4_t pixel = vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(a))));
+            sum = vmlal_n_u16(sum, pixel, static_cast<uint16_t>(w[t]));
+        }
+        vst1_u16(out + x * 4, vrshrn_n_u32(sum, shift));
+    }
+    return;
+#endif
+    for (int x = 0; x < dstW; x++) {
+        const unsigned char* p = row + static_cast<size_t>(first[x]) * 4;
+        const int16_t* w = weights + static_cast<size_t>(x) * taps;
+        int r = 0, g = 0, b = 0, a = 0;
+        for (int t = 0; t < taps; t++) {
+            r += w[t] * p[t * 4 + 0];
+            g += w[t] * p[t * 4 + 1];
+            b += w[t] * p[t * 4 + 2];
+            a += w[t] * p[t * 4 + 3];
+        }
+        const int round = 1 << (shift - 1);
+        out[x * 4 + 0] = static_cast<uint16_t>((r + round) >> shift);
+        out[x * 4 + 1] = static_cast<uint16_t>((g + round) >> shift);
+        out[x * 4 + 2] = static_cast<uint16_t>((b + round) >> shift);
+        out[x * 4 + 3] = static_cast<uint16_t>((a + round) >> shift);
+    }
+}
+
+// acc[i] += weight * row[i]
+void accumulateRow(uint32_t* acc, const uint16_t* row, int16_t weight, size_t count) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i w = _mm_set1_epi16(weight);
+    for (; i + 8 <= count; i += 8) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i lo = _mm_mullo_epi16(values, w);
+        __m128i hi = _mm_mulhi_epu16(values, w);
+        __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+        _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_unpacklo_epi16(lo, hi)));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi16(lo, hi)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t values = vld1q_u16(row + i);
+        vst1q_u32(acc + i, vmlal_n_u16(vld1q_u32(acc + i), vget_low_u16(values), static_cast<uint16_t>(weight)));
+        vst1q_u32(acc + i + 4, vmlal_n_u16(vld1q_u32(acc + i + 4), vget_high_u16(values), static_cast<uint16_t>(weight)));
+    }
+#endif
+    for (; i < count; i++) acc[i] += static_cast<uint32_t>(weight) * row[i];
+}
+
+} // namespace
+
+void areaDownscaleRGBA(unsigned char* dst, int dstStride,
+                       const unsigned char* src, int srcStride, int srcW, int srcH,
+                       int dstW, int dstH) {
+    if (dstW <= 0 || dstH <= 0 || srcW < dstW || srcH < dstH) return;
+
+    AreaWeights h(srcW, dstW);
+    AreaWeights v(srcH, dstH);
+
+    // Horizontally filtered source rows, kept in a ring of v.taps rows since
+    // consecutive output rows share source rows
+    size_t rowValues = static_cast<size_t>(dstW) * 4;
+    std::vector<uint16_t> ring(rowValues * v.taps);
+    std::vector<int> ringRow(v.taps, -1);
+    std::vector<uint32_t> acc(rowValues);
+
+    const int shift = AREA_WEIGHT_BITS + AREA_ROW_BITS;
+    for (int y = 0; y < dstH; y++) {
+        std::fill(acc.begin(), acc.end(), 0u);
+        const int16_t* wy = &v.weights[static_cast<size_t>(y) * v.taps];
+        for (int t = 0; t < v.taps; t++) {
+            if (wy[t] == 0) continue;
+            int sy = v.first[y] + t;
+            int slot = sy % v.taps;
+            uint16_t* filtered = &ring[rowValues * slot];
+            if (ringRow[slot] != sy) {
+                filterRow(filtered, src + static_cast<size_t>(sy) * srcStride, h, dstW);
+                ringRow[slot] = sy;
+            }
+            accumulateRow(acc.data(), filtered, wy[t], rowValues);
+        }
+
+        unsigned char* out = dst + static_cast<size_t>(y) * dstStride;
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i round = _mm_set1_epi32(1 << (shift - 1));
+        for (; i + 8 <= rowValues; i += 8) {
+            __m128i a = _mm_srli_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&acc[i])), round), shift);
+            __m128i b = _mm_srli_epi32(_mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&acc[i + 4])), round), shift);
+            __m128i words = _mm_packs_epi32(a, b);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words, words));
+        }
+#endif
+        for (; i < rowValues; i++) {
+            out[i] = static_cast<unsigned char>(std::min<uint32_t>((acc[i] + (1u << (shift - 1))) >> shift, 255));
+        }
+    }
+}
+
+} // namespace PixelOps
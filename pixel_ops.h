@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+// CPU pixel kernels shared by the decoders, NDI receiver and software renderer.
+// Kept free of any GL/DirectFB/FFmpeg dependency so they can be benchmarked in isolation.
+namespace PixelOps {
+
+// Copy `rows` rows of `rowBytes` each between buffers with different strides.
+// Collapses to a single memcpy when both buffers are tightly packed.
+void copyPlane(unsigned char* dst, int dstStride,
+               const unsigned char* src, int srcStride,
+               int rowBytes, int rows);
+
+// Interleave planar U and V (chroma size `width` x `height`) into an NV12-style
+// UV plane of `width * 2` bytes per row. Uses SSE2/NEON when the target has it.
+void interleaveUV(unsigned char* dst,
+                  const unsigned char* u, int uStride,
+                  const unsigned char* v, int vStride,
+                  int width, int height);
+
+// Convert RGBA to DirectFB ARGB (R/B swap) while rotating by `rotation` quarter
+// turns clockwise. Pitches are in bytes; output size is srcW x srcH, or
+// srcH x srcW for rotation 1/3.
+void swizzleRotateRGBAtoARGB(uint32_t* dst, int dstPitch,
+                             const uint32_t* src, int srcPitch, int srcW, int srcH,
+                             int rotation);
+
+// Halve an RGBA image with a 2x2 box filter. Output is (srcW / 2) x (srcH / 2);
+// an odd last column or row is dropped. Uses SSE2/NEON when the target has it.
+void halveRGBA(unsigned char* dst, int dstStride,
+               const unsigned char* src, int srcStride, int srcW, int srcH);
+
+// Area-average an RGBA image down to dstW x dstH (each no larger than the
+// source). Every output pixel averages the source area it covers, with
+// partially covered pixels weighted by their share. Separable, fixed point,
+// SSE2/NEON where available.
+void areaDownscaleRGBA(unsigned char* dst, int dstStride,
+                       const unsigned char* src, int srcStride, int srcW, int srcH,
+                       int dstW, int dstH);
+
+} // namespace PixelOps
@@ -0,0 +1,176 @@
+#include "preview_stream.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#ifdef HAVE_LIBJPEG
+#include <csetjmp>
+#include <jpeglib.h>
+
+namespace {
+    // libjpeg's default error_exit calls exit(); jump back and drop the frame instead
+    struct JpegErrorManager {
+        jpeg_error_mgr base;
+        std::jmp_buf jump;
+    };
+
+    void jpegErrorExit(j_common_ptr cinfo) {
+        char message[JMSG_LENGTH_MAX];
+        cinfo->err->format_message(cinfo, message);
+        std::cerr << "Preview: JPEG encode error: " << message << std::endl;
+        std::longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+    }
+}
+#endif
+
+PreviewStream::PreviewStream() {
+    m_thread = std::thread(&PreviewStream::encoderLoop, this);
+}
+
+PreviewStream::~PreviewStream() {
+    stop();
+}
+
+bool PreviewStream::isSupported() {
+#ifdef HAVE_LIBJPEG
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PreviewStream::setDemand(int fps, int width) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    fps = std::clamp(fps, 0, MAX_FPS);
+    if (fps > 0 && m_fps == 0) m_nextFrame = std::chrono::steady_clock::now();
+    m_fps = fps;
+    m_width = std::clamp(width, MIN_WIDTH, MAX_WIDTH);
+}
+
+void PreviewStream::setOnFrame(FrameCallback callback) {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    m_onFrame = std::move(callback);
+}
+
+void PreviewStream::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_fps = 0;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool PreviewStream::frameDue(int displayWidth, int displayHeight, int& width, int& height) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fps <= 0 || displayWidth <= 0 || displayHeight <= 0) return false;
+    // The encoder has not taken the last capture yet; don't read back another
+    if (m_hasPending) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < m_nextFrame) return false;
+    auto interval = std::chrono::microseconds(1000000 / m_fps);
+    m_nextFrame += interval;
+    if (m_nextFrame < now) m_nextFrame = now + interval;
+
+    width = std::min(m_width, displayWidth) & ~1;
+    height = std::max(2, static_cast<int>(static_cast<int64_t>(width) * displayHeight / displayWidth) & ~1);
+    return true;
+}
+
+void PreviewStream::submitFrame(const uint8_t* rgba, int width, int height, int stride) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping || m_fps <= 0) return;
+        size_t rowBytes = static_cast<size_t>(width) * 4;
+        m_pending.resize(rowBytes * height);
+        for (int y = 0; y < height; y++)
+            std::memcpy(m_pending.data() + y * rowBytes, rgba + static_cast<size_t>(y) * stride, rowBytes);
+        m_pendingWidth = width;
+        m_pendingHeight = height;
+        m_hasPending = true;
+    }
+    m_wake.notify_one();
+}
+
+void PreviewStream::encoderLoop() {
+    std::vector<uint8_t> pixels;
+    while (true) {
+        int width = 0;
+        int height = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_hasPending || m_stopping; });
+            if (m_stopping) return;
+            pixels.swap(m_pending);
+            width = m_pendingWidth;
+            height = m_pendingHeight;
+            m_hasPending = false;
+        }
+
+        auto jpeg = std::make_shared<std::string>();
+        if (!encodeJpeg(pixels.data(), width, height, width * 4, JPEG_QUALITY, *jpeg)) continue;
+
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        if (m_onFrame) m_onFrame(jpeg, width, height);
+    }
+}
+
+bool PreviewStream::encodeJpeg(const uint8_t* rgba, int width, int height, int stride,
+                               int quality, std::string& out) {
+#ifdef HAVE_LIBJPEG
+    jpeg_compress_struct cinfo;
+    JpegErrorManager jerr;
+    cinfo.err = jpeg_std_error(&jerr.base);
+    jerr.base.error_exit = jpegErrorExit;
+
+    // Everything the error path frees exists before setjmp, so the longjmp
+    // skips no destructors
+    unsigned char* buffer = nullptr;
+    unsigned long size = 0;
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    if (setjmp(jerr.jump)) {
+        jpeg_destroy_compress(&cinfo);
+        free(buffer);
+        return false;
+    }
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    // libjpeg takes packed RGB; drop alpha one row at a time
+    while (cinfo.next_scanline < cinfo.image_height) {
+        const uint8_t* src = rgba + static_cast<size_t>(cinfo.next_scanline) * stride;
+        for (int x = 0; x < width; x++) {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        JSAMPROW rowPointer = row.data();
+        jpeg_write_scanlines(&cinfo, &rowPointer, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    out.assign(reinterpret_cast<const char*>(buffer), size);
+    free(buffer);
+    return true;
+#else
+    (void)rgba;
+    (void)width;
+    (void)height;
+    (void)stride;
+    (void)quality;
+    (void)out;
+    return false;
+#endif
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Low-rate JPEG thumbnails of the composited output for control clients.
+// The render loop asks frameDue() whether to capture this frame; the
+// renderer's asynchronous readback lands in submitFrame(), which only copies
+// the pixels. Encoding happens on the stream's own thread, and a frame that
+// arrives while the previous one is still waiting is replaced, never queued.
+class PreviewStream {
+public:
+    using Jpeg = std::shared_ptr<const std::string>;
+    // Called on the encoder thread for every finished image
+    using FrameCallback = std::function<void(const Jpeg& jpeg, int width, int height)>;
+
+    static constexpr int MIN_WIDTH = 64;
+    static constexpr int MAX_WIDTH = 640;
+    static constexpr int MAX_FPS = 10;
+    static constexpr int JPEG_QUALITY = 70;
+
+    PreviewStream();
+    ~PreviewStream();
+
+    // False when built without libjpeg
+    static bool isSupported();
+
+    // Highest rate and width any client currently wants; fps 0 stops capturing
+    void setDemand(int fps, int width);
+    void setOnFrame(FrameCallback callback);
+    void stop();
+
+    // Render-loop hook: true (with the capture size, keeping the display's
+    // aspect ratio) when the frame being composited should be captured
+    bool frameDue(int displayWidth, int displayHeight, int& width, int& height);
+
+    // Finished readback from the renderer (RGBA, top row first)
+    void submitFrame(const uint8_t* rgba, int width, int height, int stride);
+
+    // Encode RGBA pixels as a baseline JPEG; false without libjpeg
+    static bool encodeJpeg(const uint8_t* rgba, int width, int height, int stride,
+                           int quality, std::string& out);
+
+private:
+    void encoderLoop();
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+    bool m_stopping = false;
+
+    int m_fps = 0;
+    int m_width = 0;
+    std::chrono::steady_clock::time_point m_nextFrame;
+
+    // Latest readback waiting for the encoder; replaced if it falls behind
+    std::vector<uint8_t> m_pending;
+    int m_pendingWidth = 0;
+    int m_pendingHeight = 0;
+    bool m_hasPending = false;
+
+    std::mutex m_callbackMutex;
+    FrameCallback m_onFrame;
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Render-loop timing for status reporting. The render loop calls frameDone()
+// once per iteration; figures are published once per second and can be read
+// from any thread. Everything shared is atomic, so readers (status polls,
+// metrics scrapes) never block the render loop.
+class RenderStats {
+public:
+    struct Snapshot {
+        double fps = 0.0;
+        double frameTimeMsAvg = 0.0;   // time spent producing a frame, excluding the cap sleep
+        double frameTimeMsMax = 0.0;
+        uint64_t frames = 0;           // since start
+        uint64_t lateFrames = 0;       // since start; frames that overran the frame budget
+        double presentSeconds = 0.0;   // since start; total time spent in IRenderer::present()
+        uint64_t presents = 0;         // since start
+    };
+
+    // Time the renderer took to present (swap / page flip) this frame
+    void presentDone(std::chrono::steady_clock::duration elapsed) {
+        m_presentNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                                 std::memory_order_relaxed);
+        m_presents.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void frameDone(std::chrono::steady_clock::duration work, std::chrono::steady_clock::duration budget) {
+        auto now = std::chrono::steady_clock::now();
+        if (m_windowStart == std::chrono::steady_clock::time_point()) m_windowStart = now;
+
+        double ms = std::chrono::duration<double, std::milli>(work).count();
+        m_windowFrames++;
+        m_windowWorkMs += ms;
+        if (ms > m_windowMaxMs) m_windowMaxMs = ms;
+        m_frames.fetch_add(1, std::memory_order_relaxed);
+        if (work > budget) m_lateFrames.fetch_add(1, std::memory_order_relaxed);
+
+        double elapsed = std::chrono::duration<double>(now - m_windowStart).count();
+        if (elapsed < 1.0) return;
+
+        m_fps.store(m_windowFrames / elapsed, std::memory_order_relaxed);
+        m_frameTimeMsAvg.store(m_windowWorkMs / m_windowFrames, std::memory_order_relaxed);
+        m_frameTimeMsMax.store(m_windowMaxMs, std::memory_order_relaxed);
+        m_windowStart = now;
+        m_windowFrames = 0;
+        m_windowWorkMs = 0.0;
+        m_windowMaxMs = 0.0;
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.fps = m_fps.load(std::memory_order_relaxed);
+        s.frameTimeMsAvg = m_frameTimeMsAvg.load(std::memory_order_relaxed);
+        s.frameTimeMsMax = m_frameTimeMsMax.load(std::memory_order_relaxed);
+        s.frames = m_frames.load(std::memory_order_relaxed);
+        s.lateFrames = m_lateFrames.load(std::memory_order_relaxed);
+        s.presentSeconds = m_presentNanos.load(std::memory_order_relaxed) / 1e9;
+        s.presents = m_presents.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    // Render thread only
+    std::chrono::steady_clock::time_point m_windowStart;
+    int m_windowFrames = 0;
+    double m_windowWorkMs = 0.0;
+    double m_windowMaxMs = 0.0;
+
+    // Published
+    std::atomic<double> m_fps{0.0};
+    std::atomic<double> m_frameTimeMsAvg{0.0};
+    std::atomic<double> m_frameTimeMsMax{0.0};
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_lateFrames{0};
+    std::atomic<uint64_t> m_presentNanos{0};
+    std::atomic<uint64_t> m_presents{0};
+};
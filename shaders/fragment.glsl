@@ -3,7 +3,15 @@ out vec4 FragColor;
 in vec2 TexCoord;
 uniform sampler2D screenTexture;
 uniform sampler2D uvTexture;
-uniform int colorFormat; // 0=RGBA, 1=UYVY, 2=UYVA, 3=NV12, 5=DMABUF_NV12
+uniform sampler2D vTexture;
+uniform int colorFormat; // 0=RGBA, 1=UYVY, 2=UYVA, 3=NV12, 4=YUV420P, 5=DMABUF_NV12, 6=mosaic
+
+// Mosaic (colorFormat 6): a grid of packed frames drawn in one pass
+#define MAX_MOSAIC_TILES 9
+uniform sampler2D mosaicTiles[MAX_MOSAIC_TILES];
+uniform int tileFormats[MAX_MOSAIC_TILES];   // colorFormat of each tile, -1 = empty
+uniform vec2 tileExtents[MAX_MOSAIC_TILES];  // fraction of the cell the frame covers
+uniform ivec2 mosaicGrid;                    // columns, rows
 
 vec4 YUVtoRGB(float Y, float U, float V) {
     // BT.601 full-range conversion matrix
@@ -52,8 +60,49 @@ vec4 NV12toRGBA(sampler2D yTex, sampler2D uvTex, vec2 texCoord) {
     return YUVtoRGB(Y, uv.r, uv.g);
 }
 
+vec4 YUV420PtoRGBA(sampler2D yTex, sampler2D uTex, sampler2D vTex, vec2 texCoord) {
+    float Y = texture(yTex, texCoord).r;
+    float U = texture(uTex, texCoord).r;
+    float V = texture(vTex, texCoord).r;
+    return YUVtoRGB(Y, U, V);
+}
+
+vec4 samplePacked(sampler2D tex, int format, vec2 texCoord) {
+    if (format == 1) return UYVYtoRGBA(tex, texCoord);
+    if (format == 2) return UYVAtoRGBA(tex, texCoord);
+    return texture(tex, texCoord);
+}
+
+vec4 mosaic(vec2 texCoord) {
+    vec2 cell = texCoord * vec2(mosaicGrid);
+    ivec2 index = min(ivec2(cell), mosaicGrid - 1);
+    int i = index.y * mosaicGrid.x + index.x;
+
+    // Letterbox the frame in the centre of its cell
+    vec2 uv = (cell - vec2(index) - 0.5) / tileExtents[i] + 0.5;
+    if (tileFormats[i] < 0 || any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0))))
+        return vec4(0.0, 0.0, 0.0, 1.0);
+
+    // Sampler arrays may only be indexed with constants
+    int format = tileFormats[i];
+    switch (i) {
+        case 0: return samplePacked(mosaicTiles[0], format, uv);
+        case 1: return samplePacked(mosaicTiles[1], format, uv);
+        case 2: return samplePacked(mosaicTiles[2], format, uv);
+        case 3: return samplePacked(mosaicTiles[3], format, uv);
+        case 4: return samplePacked(mosaicTiles[4], format, uv);
+        case 5: return samplePacked(mosaicTiles[5], format, uv);
+        case 6: return samplePacked(mosaicTiles[6], format, uv);
+        case 7: return samplePacked(mosaicTiles[7], format, uv);
+        default: return samplePacked(mosaicTiles[8], format, uv);
+    }
+}
+
 void main() {
-    if (colorFormat == 1) { // UYVY
+    if (colorFormat == 6) { // Mosaic
+        FragColor = mosaic(TexCoord);
+    }
+    else if (colorFormat == 1) { // UYVY
         FragColor = UYVYtoRGBA(screenTexture, TexCoord);
     }
     else if (colorFormat == 2) { // UYVA
@@ -62,6 +111,9 @@ void main() {
     else if (colorFormat == 3 || colorFormat == 5) { // NV12 or DMABUF_NV12
         FragColor = NV12toRGBA(screenTexture, uvTexture, TexCoord);
     }
+    else if (colorFormat == 4) { // YUV420P
+        FragColor = YUV420PtoRGBA(screenTexture, uvTexture, vTexture, TexCoord);
+    }
     else { // RGBA
         FragColor = texture(screenTexture, TexCoord);
     }
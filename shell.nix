@@ -21,6 +21,7 @@ pkgs.mkShell {
     # Common dependencies
     glfw3
     ffmpeg
+    libjpeg
 
     # Optional but useful
     ccache
@@ -0,0 +1,356 @@
+#include "test_pattern_source.h"
+#include "frame_queue.h"
+#include "log.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+namespace {
+
+struct RGB { int r, g, b; };
+
+// 75% colour bars: white, yellow, cyan, green, magenta, red, blue, black
+const RGB BARS[] = {
+    {191, 191, 191}, {191, 191, 0}, {0, 191, 191}, {0, 191, 0},
+    {191, 0, 191},   {191, 0, 0},   {0, 0, 191},   {0, 0, 0},
+};
+
+// BT.601 full range, matching YUVtoRGB() in fragment.glsl
+void rgbToYuv(const RGB& c, unsigned char& y, unsigned char& u, unsigned char& v) {
+    double Y = 0.299 * c.r + 0.587 * c.g + 0.114 * c.b;
+    double U = (c.b - Y) * 0.564 + 128.0;
+    double V = (c.r - Y) * 0.713 + 128.0;
+    y = static_cast<unsigned char>(std::clamp(Y + 0.5, 0.0, 255.0));
+    u = static_cast<unsigned char>(std::clamp(U + 0.5, 0.0, 255.0));
+    v = static_cast<unsigned char>(std::clamp(V + 0.5, 0.0, 255.0));
+}
+
+size_t frameSize(ColorFormat fmt, int w, int h) {
+    switch (fmt) {
+        case ColorFormat::NV12:
+        case ColorFormat::YUV420P: return (size_t)w * h + (size_t)(w / 2) * (h / 2) * 2;
+        case ColorFormat::UYVY: return (size_t)w * h * 2;
+        default:                return (size_t)w * h * 4;
+    }
+}
+
+// Fill [x0,x1) x [y0,y1) with a solid colour. Coordinates must be even for YUV formats.
+void fillRect(unsigned char* buf, ColorFormat fmt, int w, int h,
+              int x0, int y0, int x1, int y1, const RGB& c) {
+    x0 = std::clamp(x0, 0, w); x1 = std::clamp(x1, 0, w);
+    y0 = std::clamp(y0, 0, h); y1 = std::clamp(y1, 0, h);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    if (fmt == ColorFormat::YUV420P) {
+        unsigned char Y, U, V;
+        rgbToYuv(c, Y, U, V);
+        for (int y = y0; y < y1; y++)
+            memset(buf + (size_t)y * w + x0, Y, x1 - x0);
+        size_t cSize = (size_t)(w / 2) * (h / 2);
+        unsigned char* up = buf + (size_t)w * h;
+        unsigned char* vp = up + cSize;
+        for (int y = y0 / 2; y < y1 / 2; y++) {
+            memset(up + (size_t)y * (w / 2) + x0 / 2, U, (x1 - x0) / 2);
+            memset(vp + (size_t)y * (w / 2) + x0 / 2, V, (x1 - x0) / 2);
+        }
+    } else if (fmt == ColorFormat::NV12) {
+        unsigned char Y, U, V;
+        rgbToYuv(c, Y, U, V);
+        for (int y = y0; y < y1; y++)
+            memset(buf + (size_t)y * w + x0, Y, x1 - x0);
+        unsigned char* uv = buf + (size_t)w * h;
+        for (int y = y0 / 2; y < y1 / 2; y++) {
+            unsigned char* row = uv + (size_t)y * w;
+            for (int x = x0 / 2; x < x1 / 2; x++) {
+                row[x * 2] = U;
+                row[x * 2 + 1] = V;
+            }
+        }
+    } else if (fmt == ColorFormat::UYVY) {
+        unsigned char Y, U, V;
+        rgbToYuv(c, Y, U, V);
+        for (int y = y0; y < y1; y++) {
+            unsigned char* row = buf + (size_t)y * w * 2;
+            for (int x = x0 / 2; x < x1 / 2; x++) {
+                row[x * 4 + 0] = U;
+                row[x * 4 + 1] = Y;
+                row[x * 4 + 2] = V;
+                row[x * 4 + 3] = Y;
+            }
+        }
+    } else {
+        for (int y = y0; y < y1; y++) {
+            unsigned char* row = buf + ((size_t)y * w + x0) * 4;
+            for (int x = x0; x < x1; x++) {
+                *row++ = static_cast<unsigned char>(c.r);
+                *row++ = static_cast<unsigned char>(c.g);
+                *row++ = static_cast<unsigned char>(c.b);
+                *row++ = 255;
+            }
+        }
+    }
+}
+
+// Stamp geometry: two rows of 32 square blocks (frame counter, timestamp), MSB first
+constexpr int STAMP_BITS = 32;
+
+int stampBlockSize(int width) {
+    return std::max(2, std::min(16, width / 40)) & ~1;
+}
+
+int lumaAt(const Texture& frame, int x, int y) {
+    const unsigned char* row = frame.planeData(0) + (size_t)y * frame.planePitch(0);
+    switch (frame.format) {
+        case ColorFormat::NV12:
+        case ColorFormat::YUV420P:
+            return row[x];
+        case ColorFormat::UYVY:
+            return row[x * 2 + 1];
+        case ColorFormat::RGBA:
+            return row[x * 4];
+        default:
+            return -1;
+    }
+}
+
+} // namespace
+
+bool TestPatternSource::parse(const std::string& url, Params& out, std::string& error) {
+    if (!isTestSource(url)) {
+        error = "not a testsrc:// URL";
+        return false;
+    }
+    Params p;
+    std::string rest = url.substr(10);
+    std::string query;
+    size_t q = rest.find('?');
+    if (q != std::string::npos) {
+        query = rest.substr(q + 1);
+        rest = rest.substr(0, q);
+    }
+
+    if (!rest.empty()) {
+        std::string size = rest;
+        size_t at = rest.find('@');
+        if (at != std::string::npos) {
+            size = rest.substr(0, at);
+            p.fps = std::atof(rest.c_str() + at + 1);
+        }
+        if (!size.empty() && sscanf(size.c_str(), "%dx%d", &p.width, &p.height) != 2) {
+            error = "invalid size, expected WIDTHxHEIGHT";
+            return false;
+        }
+    }
+
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t amp = query.find('&', pos);
+        std::string kv = query.substr(pos, amp == std::string::npos ? std::string::npos : amp - pos);
+        pos = (amp == std::string::npos) ? query.size() : amp + 1;
+        size_t eq = kv.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = kv.substr(0, eq);
+        std::string value = kv.substr(eq + 1);
+        if (key == "format") {
+            if (value == "nv12") p.format = ColorFormat::NV12;
+            else if (value == "rgba") p.format = ColorFormat::RGBA;
+            else if (value == "uyvy") p.format = ColorFormat::UYVY;
+            else if (value == "yuv420p") p.format = ColorFormat::YUV420P;
+            else {
+                error = "unsupported format '" + value + "' (nv12, yuv420p, rgba, uyvy)";
+                return false;
+            }
+        } else if (key == "frames") {
+            p.frameLimit = std::max<int64_t>(0, std::atoll(value.c_str()));
+        }
+    }
+
+    if (p.width < 64 || p.height < 64 || p.width > 7680 || p.height > 4320 ||
+        (p.width & 1) || (p.height & 1)) {
+        error = "size must be even and between 64x64 and 7680x4320";
+        return false;
+    }
+    if (!(p.fps > 0.0 && p.fps <= 240.0)) {
+        error = "fps must be between 0 and 240";
+        return false;
+    }
+
+    out = p;
+    return true;
+}
+
+TestPatternSource::TestPatternSource(const Params& params) : m_params(params) {
+    buildBackground();
+}
+
+TestPatternSource::~TestPatternSource() {
+    stop();
+}
+
+void TestPatternSource::buildBackground() {
+    int w = m_params.width, h = m_params.height;
+    m_background.assign(frameSize(m_params.format, w, h), 0);
+    fillRect(m_background.data(), m_params.format, w, h, 0, 0, w, h, BARS[7]);
+
+    int barCount = static_cast<int>(sizeof(BARS) / sizeof(BARS[0]));
+    for (int i = 0; i < barCount; i++) {
+        int x0 = (w * i / barCount) & ~1;
+        int x1 = (w * (i + 1) / barCount) & ~1;
+        fillRect(m_background.data(), m_params.format, w, h, x0, 0, x1, h * 3 / 4 & ~1, BARS[i]);
+    }
+    // Bottom quarter: greyscale ramp for banding checks
+    int steps = 16;
+    for (int i = 0; i < steps; i++) {
+        int level = i * 255 / (steps - 1);
+        int x0 = (w * i / steps) & ~1;
+        int x1 = (w * (i + 1) / steps) & ~1;
+        fillRect(m_background.data(), m_params.format, w, h, x0, h * 3 / 4 & ~1, x1, h,
+                 RGB{level, level, level});
+    }
+}
+
+Texture TestPatternSource::generate(uint32_t frameIndex, uint32_t timestampMs) const {
+    int w = m_params.width, h = m_params.height;
+    std::vector<unsigned char> pixels(m_background);
+
+    // Moving bar (one full sweep every ~2s at 60 fps) makes tearing/judder visible
+    int block = stampBlockSize(w);
+    int barW = block * 2;
+    int travel = std::max(2, w - barW);
+    int barX = static_cast<int>((static_cast<uint64_t>(frameIndex) * (w / 120 + 2)) % travel) & ~1;
+    fillRect(pixels.data(), m_params.format, w, h, barX, block * 2, barX + barW, h, RGB{255, 255, 255});
+
+    uint32_t words[2] = { frameIndex, timestampMs };
+    for (int row = 0; row < 2; row++) {
+        for (int bit = 0; bit < STAMP_BITS; bit++) {
+            bool set = (words[row] >> (STAMP_BITS - 1 - bit)) & 1u;
+            int x0 = bit * block;
+            int y0 = row * block;
+            fillRect(pixels.data(), m_params.format, w, h, x0, y0, x0 + block, y0 + block,
+                     set ? RGB{255, 255, 255} : RGB{0, 0, 0});
+        }
+    }
+
+    Texture tex;
+    bool planar = m_params.format == ColorFormat::NV12 || m_params.format == ColorFormat::YUV420P;
+    int channels = planar ? 1 : 4;
+    tex.setOwnedPixels(std::move(pixels), w, h, channels, m_params.format);
+    return tex;
+}
+
+bool TestPatternSource::readStamp(const Texture& frame, uint32_t& frameIndex, uint32_t& timestampMs) {
+    if (!frame.pixels) return false;
+    int block = stampBlockSize(frame.width);
+    if (frame.width < block * STAMP_BITS || frame.height < block * 2) return false;
+
+    uint32_t words[2] = { 0, 0 };
+    for (int row = 0; row < 2; row++) {
+        for (int bit = 0; bit < STAMP_BITS; bit++) {
+            int luma = lumaAt(frame, bit * block + block / 2, row * block + block / 2);
+            if (luma < 0) return false;
+            words[row] = (words[row] << 1) | (luma >= 128 ? 1u : 0u);
+        }
+    }
+    frameIndex = words[0];
+    timestampMs = words[1];
+    return true;
+}
+
+uint32_t TestPatternSource::nowMs() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+void TestPatternSource::start(FrameQueue& queue) {
+    if (m_running) return;
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats = Stats{};
+        m_havePresented = false;
+        m_lastReport = std::chrono::steady_clock::now();
+    }
+    m_running = true;
+    m_thread = std::thread(&TestPatternSource::generatorLoop, this, &queue);
+}
+
+void TestPatternSource::stop() {
+    m_running = false;
+    if (m_thread.joinable()) {
+        // The end-of-stream callback may stop us from the generator thread itself
+        if (m_thread.get_id() == std::this_thread::get_id())
+            m_thread.detach();
+        else
+            m_thread.join();
+    }
+}
+
+void TestPatternSource::generatorLoop(FrameQueue* queue) {
+    LOG_INFO("Test pattern: " << m_params.width << "x" << m_params.height
+             << " @ " << m_params.fps << " fps");
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / m_params.fps));
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t n = 0; m_running; n++) {
+        // Fixed schedule: a slow generator shows up as drops, not as a slower clock
+        std::this_thread::sleep_until(start + period * n);
+        if (!m_running) break;
+
+        Texture frame = generate(n, nowMs());
+        queue->push(n / m_params.fps, std::move(frame), false);
+
+        Stats snapshot;
+        bool report = false;
+        {
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.generated++;
+            auto now = std::chrono::steady_clock::now();
+            if (now - m_lastReport >= std::chrono::seconds(10)) {
+                snapshot = m_stats;
+                m_lastReport = now;
+                report = true;
+            }
+        }
+        if (report) {
+            LOG_INFO("Test pattern: generated " << snapshot.generated
+                     << " | presented " << snapshot.presented
+                     << " | repeated " << snapshot.repeated
+                     << " | dropped " << snapshot.dropped
+                     << " | latency avg " << snapshot.latencyMsAvg
+                     << " ms, max " << snapshot.latencyMsMax << " ms");
+        }
+
+        if (m_params.frameLimit > 0 && n + 1 >= m_params.frameLimit) {
+            m_running = false;
+            if (m_onEnd) m_onEnd();
+            break;
+        }
+    }
+}
+
+void TestPatternSource::onPresented(const Texture& frame) {
+    uint32_t index, stampMs;
+    if (!readStamp(frame, index, stampMs)) return;
+    uint32_t latency = nowMs() - stampMs;  // wraps correctly in uint32_t
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    if (m_havePresented && index == m_lastPresented) {
+        m_stats.repeated++;
+        return;
+    }
+    if (m_havePresented && index > m_lastPresented + 1)
+        m_stats.dropped += index - m_lastPresented - 1;
+
+    m_stats.presented++;
+    m_stats.latencyMsAvg += (latency - m_stats.latencyMsAvg) / static_cast<double>(m_stats.presented);
+    m_stats.latencyMsMax = std::max(m_stats.latencyMsMax, static_cast<double>(latency));
+    m_lastPresented = index;
+    m_havePresented = true;
+}
+
+TestPatternSource::Stats TestPatternSource::getStats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include "texture.h"
+
+class FrameQueue;
+
+// Built-in synthetic video source for soak/load testing: `testsrc://1920x1080@60?format=nv12`.
+// Generates colour bars with a moving bar at a fixed wall-clock rate and embeds a
+// machine-readable stamp (frame counter + generation time) in the top-left corner,
+// so the render loop can detect dropped/repeated frames and measure latency.
+class TestPatternSource {
+public:
+    struct Params {
+        int width = 1920;
+        int height = 1080;
+        double fps = 60.0;
+        ColorFormat format = ColorFormat::NV12;
+        int64_t frameLimit = 0;  // 0 = run until stopped
+    };
+
+    struct Stats {
+        uint64_t generated = 0;     // frames pushed to the queue
+        uint64_t presented = 0;     // distinct frames shown by the render loop
+        uint64_t repeated = 0;      // render ticks that showed an already-seen frame
+        uint64_t dropped = 0;       // counter gaps between consecutive presented frames
+        double latencyMsAvg = 0.0;  // generation -> first present
+        double latencyMsMax = 0.0;
+    };
+
+    // Parse `testsrc://WxH@FPS?format=nv12|yuv420p|rgba|uyvy&frames=N`. All parts optional.
+    static bool parse(const std::string& url, Params& out, std::string& error);
+    static bool isTestSource(const std::string& url) { return url.rfind("testsrc://", 0) == 0; }
+
+    explicit TestPatternSource(const Params& params);
+    ~TestPatternSource();
+
+    void start(FrameQueue& queue);
+    void stop();
+    bool isRunning() const { return m_running; }
+    const Params& params() const { return m_params; }
+
+    // Called by the generator when `frames=N` is reached
+    void setOnEndCallback(std::function<void()> cb) { m_onEnd = std::move(cb); }
+
+    // Render one frame with the given stamp (also used by the benchmark)
+    Texture generate(uint32_t frameIndex, uint32_t timestampMs) const;
+
+    // Decode the stamp from a frame produced by generate(). Returns false if
+    // the texture carries no readable stamp.
+    static bool readStamp(const Texture& frame, uint32_t& frameIndex, uint32_t& timestampMs);
+
+    // Render-loop hook: account for the frame that was just presented
+    void onPresented(const Texture& frame);
+    Stats getStats() const;
+
+    static uint32_t nowMs();
+
+private:
+    void generatorLoop(FrameQueue* queue);
+    void buildBackground();
+
+    Params m_params;
+    std::vector<unsigned char> m_background;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::function<void()> m_onEnd;
+
+    mutable std::mutex m_statsMutex;
+    Stats m_stats;
+    bool m_havePresented = false;
+    uint32_t m_lastPresented = 0;
+    std::chrono::steady_clock::time_point m_lastReport;
+};
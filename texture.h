@@ -1,5 +1,7 @@
 #pragma once
 #include <vector>
+#include <memory>
+#include <cstddef>
 #include <cstdint>
 
 enum class ColorFormat {
@@ -8,10 +10,22 @@ enum class ColorFormat {
     UYVA,
     NV12,
     YUV420P,     // Planar YUV: Y + U + V separate planes
-    DMABUF_NV12  // VA-API DMA-BUF: pixels is unused, dmabuf fields carry the fd
+    DMABUF_NV12  // VA-API DMA-BUF: pixels is unused, planes carry the fds
+};
+
+// Layout of one image plane, so producers can hand over their native layout
+// (padded rows, separate plane buffers, DMA-BUF objects) without repacking.
+struct TexturePlane {
+    const unsigned char* data = nullptr;  // plane outside `pixels` (kept alive by sharedStorage)
+    size_t offset = 0;   // bytes from `pixels` when data is null; offset into dmaFd for DMA-BUF
+    int pitch = 0;       // bytes per row
+    int bitDepth = 8;    // bits per sample; > 8 is stored in MSB-aligned 16-bit words
+    int dmaFd = -1;      // DMA-BUF object holding this plane (may repeat across planes)
 };
 
 struct Texture {
+    static constexpr int MAX_PLANES = 4;
+
     unsigned char* pixels = nullptr;
     int width = 0;
     int height = 0;
@@ -21,21 +35,37 @@ struct Texture {
     // Optional owned buffer for dynamically-generated frames (video, NDI)
     std::vector<unsigned char> ownedPixels;
 
+    // Optional shared buffer (pooled decoder frames, DMA-BUF fds). Copies share
+    // it instead of duplicating the pixels; it is released with the last copy.
+    std::shared_ptr<void> sharedStorage;
+
+    // Explicit plane layout. planeCount == 0 means the planes are tightly packed
+    // after `pixels` in the default layout for `format`.
+    int planeCount = 0;
+    TexturePlane planes[MAX_PLANES];
+
+    uint32_t dmaFourcc = 0;   // DRM fourcc of DMA-BUF frames
+
     Texture() = default;
 
     Texture(const Texture& other)
         : width(other.width), height(other.height), channels(other.channels),
-          format(other.format), ownedPixels(other.ownedPixels) {
-        pixels = ownedPixels.empty() ? nullptr : ownedPixels.data();
+          format(other.format), ownedPixels(other.ownedPixels),
+          sharedStorage(other.sharedStorage) {
+        pixels = sharedStorage ? other.pixels : (ownedPixels.empty() ? nullptr : ownedPixels.data());
+        copyPlaneLayout(other);
     }
 
     Texture(Texture&& other) noexcept
         : width(other.width), height(other.height), channels(other.channels),
-          format(other.format), ownedPixels(std::move(other.ownedPixels)) {
-        pixels = ownedPixels.empty() ? nullptr : ownedPixels.data();
+          format(other.format), ownedPixels(std::move(other.ownedPixels)),
+          sharedStorage(std::move(other.sharedStorage)) {
+        pixels = sharedStorage ? other.pixels : (ownedPixels.empty() ? nullptr : ownedPixels.data());
+        copyPlaneLayout(other);
         other.pixels = nullptr;
         other.width = 0;
         other.height = 0;
+        other.resetPlaneLayout();
     }
 
     Texture& operator=(const Texture& other) {
@@ -45,7 +75,9 @@ struct Texture {
             channels = other.channels;
             format = other.format;
             ownedPixels = other.ownedPixels;
-            pixels = ownedPixels.empty() ? nullptr : ownedPixels.data();
+            sharedStorage = other.sharedStorage;
+            pixels = sharedStorage ? other.pixels : (ownedPixels.empty() ? nullptr : ownedPixels.data());
+            copyPlaneLayout(other);
         }
         return *this;
     }
@@ -57,24 +89,80 @@ struct Texture {
             channels = other.channels;
             format = other.format;
             ownedPixels = std::move(other.ownedPixels);
-            pixels = ownedPixels.empty() ? nullptr : ownedPixels.data();
+            sharedStorage = std::move(other.sharedStorage);
+            pixels = sharedStorage ? other.pixels : (ownedPixels.empty() ? nullptr : ownedPixels.data());
+            copyPlaneLayout(other);
             other.pixels = nullptr;
             other.width = 0;
             other.height = 0;
+            other.resetPlaneLayout();
         }
         return *this;
     }
 
-    // DMA-BUF info for zero-copy VA-API frames
-    int dmaFd = -1;           // DMA-BUF file descriptor
-    uint32_t dmaOffset[2] = {};  // plane offsets (Y, UV)
-    uint32_t dmaPitch[2] = {};   // plane pitches
-    uint32_t dmaFourcc = 0;      // DRM fourcc format
+    bool isValid() const { return pixels != nullptr || planes[0].dmaFd >= 0; }
+
+    int numPlanes() const {
+        if (planeCount > 0) return planeCount;
+        switch (format) {
+            case ColorFormat::NV12:        return 2;
+            case ColorFormat::YUV420P:     return 3;
+            case ColorFormat::DMABUF_NV12: return 0;
+            default:                       return 1;
+        }
+    }
+
+    // Start of plane `i` in memory (Y/UV for NV12, Y/U/V for YUV420P)
+    const unsigned char* planeData(int i) const {
+        if (planeCount > 0)
+            return planes[i].data ? planes[i].data : pixels + planes[i].offset;
+        size_t ySize = (size_t)width * height;
+        size_t cSize = (size_t)(width / 2) * (height / 2);
+        switch (format) {
+            case ColorFormat::NV12:    return pixels + (i == 0 ? 0 : ySize);
+            case ColorFormat::YUV420P: return pixels + (i == 0 ? 0 : ySize + (i - 1) * cSize);
+            default:                   return pixels;
+        }
+    }
+
+    // Row pitch of plane `i` in bytes
+    int planePitch(int i) const {
+        if (planeCount > 0) return planes[i].pitch;
+        switch (format) {
+            case ColorFormat::UYVY:    return width * 2;
+            case ColorFormat::NV12:    return width;
+            case ColorFormat::YUV420P: return i == 0 ? width : width / 2;
+            default:                   return width * 4;
+        }
+    }
 
-    bool isValid() const { return pixels != nullptr || dmaFd >= 0; }
+    int planeBitDepth(int i) const { return planeCount > 0 ? planes[i].bitDepth : 8; }
+
+    // Describe plane `i` at `offset` bytes from `pixels`
+    void setPlane(int i, size_t offset, int pitch, int bitDepth = 8) {
+        planes[i] = TexturePlane{};
+        planes[i].offset = offset;
+        planes[i].pitch = pitch;
+        planes[i].bitDepth = bitDepth;
+        if (planeCount < i + 1) planeCount = i + 1;
+    }
+
+    // Describe plane `i` living in a separate buffer; sharedStorage must keep it alive
+    void setPlanePointer(int i, const unsigned char* data, int pitch, int bitDepth = 8) {
+        setPlane(i, 0, pitch, bitDepth);
+        planes[i].data = data;
+    }
+
+    // Describe plane `i` of a DMA-BUF frame
+    void setDmaPlane(int i, int fd, size_t offset, int pitch) {
+        setPlane(i, offset, pitch);
+        planes[i].dmaFd = fd;
+    }
 
     // Set pixels from owned buffer with proper RAII
     void setOwnedPixels(std::vector<unsigned char>&& data, int w, int h, int ch, ColorFormat fmt) {
+        sharedStorage.reset();
+        resetPlaneLayout();
         ownedPixels = std::move(data);
         pixels = ownedPixels.data();
         width = w;
@@ -82,4 +170,30 @@ struct Texture {
         channels = ch;
         format = fmt;
     }
-};
\ No newline at end of file
+
+    // Reference pixels inside a shared buffer; `storage` keeps `data` alive
+    void setSharedPixels(std::shared_ptr<void> storage, unsigned char* data, int w, int h, int ch, ColorFormat fmt) {
+        ownedPixels.clear();
+        resetPlaneLayout();
+        sharedStorage = std::move(storage);
+        pixels = data;
+        width = w;
+        height = h;
+        channels = ch;
+        format = fmt;
+    }
+
+private:
+    void copyPlaneLayout(const Texture& other) {
+        planeCount = other.planeCount;
+        for (int i = 0; i < MAX_PLANES; i++)
+            planes[i] = other.planes[i];
+        dmaFourcc = other.dmaFourcc;
+    }
+    void resetPlaneLayout() {
+        planeCount = 0;
+        for (int i = 0; i < MAX_PLANES; i++)
+            planes[i] = TexturePlane{};
+        dmaFourcc = 0;
+    }
+};
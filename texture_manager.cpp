@@ -1,99 +1,316 @@
 #include "texture_manager.h"
 #include "loader.h"
-#include <filesystem>
 #include <algorithm>
 #include <iostream>
+#include <thread>
 #include "config.h"
 
-TextureManager::TextureManager() {}
+namespace {
+    // Leave a core for the render loop; more than four rarely pays off for stb_image
+    int decodeWorkers() {
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        return std::clamp(cores - 1, 1, 4);
+    }
+}
+
+TextureManager::TextureManager() : m_decoders(decodeWorkers()) {}
 
 TextureManager::~TextureManager() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_decoders.shutdown();
     unloadAll();
 }
 
-void TextureManager::scanTextureDirectory() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    availableTextures.clear();
-
-    for (const auto& entry : std::filesystem::directory_iterator(MEDIA_PATH)) {
-        if (entry.is_regular_file()) {
-            std::string ext = entry.path().extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+void TextureManager::applyMediaChange(const MediaIndex::Change& change) {
+    std::string reload;
+    int targetWidth = 0;
+    int targetHeight = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& name : change.added) {
+            if (!MediaIndex::isImage(name)) continue;
+            auto at = std::lower_bound(availableTextures.begin(), availableTextures.end(), name);
+            if (at == availableTextures.end() || *at != name) availableTextures.insert(at, name);
+        }
+        for (const auto& name : change.removed) {
+            auto at = std::lower_bound(availableTextures.begin(), availableTextures.end(), name);
+            if (at != availableTextures.end() && *at == name) availableTextures.erase(at);
+        }
 
-            if (ext == ".jpg" || ext == ".jpeg" || ext == ".png") {
-                availableTextures.push_back(entry.path().filename().string());
+        // Cached decodes of replaced or deleted files are stale. The image on
+        // screen stays until its replacement is decoded; a deleted one stays.
+        auto dropStale = [&](const std::string& name, bool replaced) {
+            auto it = textures.find(name);
+            if (it == textures.end()) return;
+            if (name == currentTextureName) {
+                if (replaced) reload = name;
+                return;
             }
-        }
+            if (name == m_nextTextureName) m_nextTextureName.clear();
+            erase(it);
+        };
+        for (const auto& name : change.modified) dropStale(name, true);
+        for (const auto& name : change.removed) dropStale(name, false);
+        updateCacheStats();
+        targetWidth = m_targetWidth;
+        targetHeight = m_targetHeight;
     }
+    if (reload.empty()) return;
+    redecodeCurrent(reload, targetWidth, targetHeight);
 }
 
-bool TextureManager::loadTexture(const std::string& filename) {
+void TextureManager::reloadCurrent() {
+    std::string name;
+    int targetWidth = 0;
+    int targetHeight = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        name = currentTextureName;
+        targetWidth = m_targetWidth;
+        targetHeight = m_targetHeight;
+    }
+    if (!name.empty()) redecodeCurrent(name, targetWidth, targetHeight);
+}
+
+void TextureManager::redecodeCurrent(const std::string& name, int targetWidth, int targetHeight) {
+    Texture texture;
+    if (!decode(name, targetWidth, targetHeight, texture)) return;
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (textures.find(filename) != textures.end()) {
-        lastUsed[filename] = std::chrono::steady_clock::now();
-        return true;
+    auto it = textures.find(name);
+    // Shown something else meanwhile, or the target changed again
+    if (name != currentTextureName || it == textures.end() ||
+        targetWidth != m_targetWidth || targetHeight != m_targetHeight) {
+        return;
     }
+    erase(it);
+    insert(name, std::move(texture));
+    currentTexture = &textures.at(name).texture;
+    publishCurrent();
+    evictToBudget();
+    updateCacheStats();
+}
 
+bool TextureManager::decode(const std::string& name, int targetWidth, int targetHeight, Texture& texture) {
+    std::string path = MEDIA_PATH + name;
+    if (m_diskCache.load(path, targetWidth, targetHeight, texture)) return true;
     try {
         Loader loader;
-        Texture texture = loader.LoadTexture(filename, ColorFormat::RGBA);
-
-        if (texture.pixels != nullptr) {
-            textures[filename] = std::move(texture);
-            lastUsed[filename] = std::chrono::steady_clock::now();
-            return true;
-        }
+        texture = loader.LoadTexture(name, ColorFormat::RGBA, targetWidth, targetHeight);
+        if (!texture.pixels) return false;
+        m_diskCache.store(path, targetWidth, targetHeight, texture);
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "Failed to load texture: " << e.what() << std::endl;
     }
     return false;
 }
 
-bool TextureManager::setCurrentTexture(const std::string& name) {
-    std::unique_lock<std::mutex> lock(m_mutex);
+std::vector<TextureManager::PlannedDecode> TextureManager::probe(const std::vector<std::string>& names,
+                                                                 int targetWidth, int targetHeight) {
+    std::vector<PlannedDecode> plan;
+    Loader loader;
+    for (const auto& name : names) {
+        PlannedDecode item;
+        item.name = name;
+        int width = 0;
+        int height = 0;
+        item.found = loader.ProbeTexture(name, width, height);
+        Loader::ScaledSize(width, height, targetWidth, targetHeight, width, height);
+        item.bytes = (size_t)width * height * 4;
+        plan.push_back(item);
+    }
+    return plan;
+}
+
+size_t TextureManager::decodedBytes(const Texture& texture) {
+    // Loader always expands to RGBA, whatever `channels` says about the file
+    if (!texture.ownedPixels.empty()) return texture.ownedPixels.size();
+    return (size_t)texture.width * texture.height * 4;
+}
 
-    // Auto-load if not already in memory
-    if (textures.find(name) == textures.end()) {
-        // Release lock for I/O, then re-acquire
+bool TextureManager::ensureLoaded(const std::string& name, std::unique_lock<std::mutex>& lock) {
+    if (textures.count(name)) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    while (true) {
+        auto pending = m_decoding.find(name);
+        if (pending != m_decoding.end()) {
+            std::shared_future<bool> done = pending->second;
+            lock.unlock();
+            bool ok = done.get();
+            lock.lock();
+            if (!ok) return false;
+            // Normally resident now; decoded again below if evicted meanwhile
+            if (textures.count(name)) return true;
+            continue;
+        }
+
+        // Nobody is decoding it: do it here, and let prefetches wait on us
+        std::promise<bool> promise;
+        m_decoding[name] = promise.get_future().share();
+        m_decodingCount.fetch_add(1, std::memory_order_relaxed);
+        int targetWidth = m_targetWidth;
+        int targetHeight = m_targetHeight;
         lock.unlock();
-        Loader loader;
         Texture texture;
-        bool loaded = false;
-        try {
-            texture = loader.LoadTexture(name, ColorFormat::RGBA);
-            loaded = texture.pixels != nullptr;
-        } catch (const std::exception& e) {
-            std::cerr << "Failed to load texture: " << e.what() << std::endl;
-        }
+        bool ok = decode(name, targetWidth, targetHeight, texture);
         lock.lock();
+        m_decoding.erase(name);
+        m_decodingCount.fetch_sub(1, std::memory_order_relaxed);
+        if (ok) {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            if (!textures.count(name)) insert(name, std::move(texture));
+        }
+        promise.set_value(ok);
+        return ok;
+    }
+}
+
+bool TextureManager::loadTexture(const std::string& filename) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!ensureLoaded(filename, lock)) return false;
+
+    touch(textures.at(filename));
+    m_nextTextureName = filename;
+    evictToBudget();
+    updateCacheStats();
+    return true;
+}
 
-        if (!loaded) return false;
-        textures[name] = std::move(texture);
-        lastUsed[name] = std::chrono::steady_clock::now();
+bool TextureManager::setCurrentTexture(const std::string& name) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!ensureLoaded(name, lock)) return false;
+    makeCurrent(name);
+    decodeAhead(name, lock);
+    return true;
+}
+
+bool TextureManager::showResident(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (textures.find(name) == textures.end()) return false;
+    makeCurrent(name);
+    return true;
+}
+
+void TextureManager::prefetchAhead() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (currentTextureName.empty()) return;
+    decodeAhead(currentTextureName, lock);
+}
+
+void TextureManager::makeCurrent(const std::string& name) {
+    Entry& entry = textures.at(name);
+    touch(entry);
+    currentTexture = &entry.texture;
+    currentTextureName = name;
+    publishCurrent();
+    if (m_nextTextureName == name) m_nextTextureName.clear();
+
+    // Showing a scheduled image pins the one after it
+    auto scheduled = std::find(m_schedule.begin(), m_schedule.end(), name);
+    if (scheduled != m_schedule.end() && std::next(scheduled) != m_schedule.end()) {
+        m_nextTextureName = *std::next(scheduled);
     }
 
-    auto it = textures.find(name);
-    if (it != textures.end()) {
-        currentTexture = &it->second;
-        currentTextureName = name;
-        lastUsed[name] = std::chrono::steady_clock::now();
-        cleanupUnused();
-        return true;
+    evictToBudget();
+    updateCacheStats();
+}
+
+void TextureManager::decodeAhead(const std::string& name, std::unique_lock<std::mutex>& lock) {
+    std::vector<std::string> ahead;
+    auto scheduled = std::find(m_schedule.begin(), m_schedule.end(), name);
+    if (scheduled != m_schedule.end() && std::next(scheduled) != m_schedule.end()) {
+        auto last = std::next(scheduled) + std::min<std::ptrdiff_t>(AUTO_PREFETCH_AHEAD,
+                                                                   m_schedule.end() - std::next(scheduled));
+        ahead.assign(std::next(scheduled), last);
     }
-    return false;
+    if (ahead.empty()) return;
+
+    int targetWidth = m_targetWidth;
+    int targetHeight = m_targetHeight;
+    lock.unlock();
+    auto plan = probe(ahead, targetWidth, targetHeight);
+    lock.lock();
+    std::vector<std::string> queued;
+    std::vector<std::string> skipped;
+    queueDecodes(plan, queued, skipped);
 }
 
-Texture TextureManager::getCurrentTextureCopy() const {
+void TextureManager::prefetch(const std::vector<std::string>& names,
+                              std::vector<std::string>& queued, std::vector<std::string>& skipped) {
+    int targetWidth = 0;
+    int targetHeight = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        targetWidth = m_targetWidth;
+        targetHeight = m_targetHeight;
+    }
+    auto plan = probe(names, targetWidth, targetHeight);
     std::lock_guard<std::mutex> lock(m_mutex);
-    if (currentTexture) {
-        return *currentTexture;  // Safe copy thanks to proper copy constructor
+    m_schedule = names;
+    queueDecodes(plan, queued, skipped);
+}
+
+void TextureManager::queueDecodes(const std::vector<PlannedDecode>& plan,
+                                  std::vector<std::string>& queued, std::vector<std::string>& skipped) {
+    // Stop before the schedule would evict its own earlier entries
+    size_t planned = currentTexture ? decodedBytes(*currentTexture) : 0;
+    bool full = false;
+    for (const auto& item : plan) {
+        const std::string& name = item.name;
+        if (name == currentTextureName) continue;
+        auto cached = textures.find(name);
+        if (cached != textures.end()) {
+            planned += cached->second.bytes;
+            continue;
+        }
+        if (full || !item.found || m_stopping) {
+            skipped.push_back(name);
+            continue;
+        }
+        planned += item.bytes;
+        if (planned > m_budgetBytes) {
+            full = true;
+            skipped.push_back(name);
+            continue;
+        }
+        queued.push_back(name);
+        if (m_decoding.count(name)) continue;
+
+        auto promise = std::make_shared<std::promise<bool>>();
+        m_decoding[name] = promise->get_future().share();
+        m_decodingCount.fetch_add(1, std::memory_order_relaxed);
+        int targetWidth = m_targetWidth;
+        int targetHeight = m_targetHeight;
+        m_decoders.submit("decode:" + name, [this, name, promise, targetWidth, targetHeight](uint64_t, const std::atomic<bool>&) {
+            Texture texture;
+            bool ok = decode(name, targetWidth, targetHeight, texture);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_decoding.erase(name);
+            m_decodingCount.fetch_sub(1, std::memory_order_relaxed);
+            if (ok) {
+                m_misses.fetch_add(1, std::memory_order_relaxed);
+                if (!textures.count(name)) insert(name, std::move(texture));
+                evictToBudget();
+                updateCacheStats();
+            }
+            promise->set_value(ok);
+        }, [this, name, promise](uint64_t, uint64_t) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_decoding.erase(name);
+            m_decodingCount.fetch_sub(1, std::memory_order_relaxed);
+            promise->set_value(false);
+        });
     }
-    return Texture{};
 }
 
 std::string TextureManager::getCurrentTextureName() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return currentTextureName;
+    auto current = getCurrent();
+    return current ? current->name : std::string();
 }
 
 std::vector<std::string> TextureManager::getAvailableTextures() const {
@@ -106,38 +323,151 @@ void TextureManager::unloadTexture(const std::string& name) {
     if (name == currentTextureName) {
         currentTexture = nullptr;
         currentTextureName.clear();
+        publishCurrent();
     }
-    textures.erase(name);
-    lastUsed.erase(name);
+    if (name == m_nextTextureName) m_nextTextureName.clear();
+    auto it = textures.find(name);
+    if (it != textures.end()) erase(it);
+    updateCacheStats();
 }
 
 void TextureManager::unloadAll() {
     std::lock_guard<std::mutex> lock(m_mutex);
     textures.clear();
-    lastUsed.clear();
+    m_lru.clear();
+    m_bytes = 0;
     currentTexture = nullptr;
     currentTextureName.clear();
+    publishCurrent();
+    m_nextTextureName.clear();
+    updateCacheStats();
 }
 
-void TextureManager::cleanupUnused() {
-    auto now = std::chrono::steady_clock::now();
-    auto cutoff = std::chrono::seconds(TEXTURE_RETAIN_SECONDS);
+void TextureManager::setCacheBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budgetBytes = bytes;
+    m_cacheBudget.store(bytes, std::memory_order_relaxed);
+    evictToBudget();
+    updateCacheStats();
+}
 
-    for (auto it = textures.begin(); it != textures.end(); ) {
-        const std::string& name = it->first;
+bool TextureManager::openDiskCache(const std::string& directory, size_t maxBytes) {
+    return m_diskCache.open(directory, maxBytes);
+}
 
-        // Never unload the active texture
-        if (name == currentTextureName) {
-            ++it;
-            continue;
-        }
+ImageDiskCache::Stats TextureManager::getDiskCacheStats() const {
+    return m_diskCache.getStats();
+}
 
-        auto usedIt = lastUsed.find(name);
-        if (usedIt != lastUsed.end() && (now - usedIt->second) > cutoff) {
-            usedIt = lastUsed.erase(usedIt);
-            it = textures.erase(it);
-        } else {
-            ++it;
+bool TextureManager::setTargetSize(int width, int height) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (width == m_targetWidth && height == m_targetHeight) return false;
+    m_targetWidth = width;
+    m_targetHeight = height;
+    for (auto it = textures.begin(); it != textures.end();) {
+        auto next = std::next(it);
+        if (!isPinned(it->first)) erase(it);
+        it = next;
+    }
+    updateCacheStats();
+    return true;
+}
+
+TextureManager::CacheStats TextureManager::getCacheStats() const {
+    CacheStats stats;
+    stats.textures = m_cachedTextures.load(std::memory_order_relaxed);
+    stats.bytes = m_cachedBytes.load(std::memory_order_relaxed);
+    stats.budgetBytes = m_cacheBudget.load(std::memory_order_relaxed);
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+    stats.evictions = m_evictions.load(std::memory_order_relaxed);
+    stats.decoding = m_decodingCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::vector<TextureManager::CacheEntry> TextureManager::getCacheEntries() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<CacheEntry> entries;
+    for (const auto& name : m_lru) {
+        const Entry& entry = textures.at(name);
+        CacheEntry info;
+        info.name = name;
+        info.width = entry.texture.width;
+        info.height = entry.texture.height;
+        info.bytes = entry.bytes;
+        info.pinned = isPinned(name);
+        entries.push_back(info);
+    }
+    return entries;
+}
+
+void TextureManager::insert(const std::string& name, Texture&& texture) {
+    Entry& entry = textures[name];
+    entry.bytes = decodedBytes(texture);
+    entry.version = ++m_lastVersion;
+    entry.texture = std::move(texture);
+    // Keep heap pixels in shared storage, so snapshots of the entry never copy them
+    if (!entry.texture.sharedStorage && !entry.texture.ownedPixels.empty()) {
+        Texture& t = entry.texture;
+        auto storage = std::make_shared<std::vector<unsigned char>>(std::move(t.ownedPixels));
+        t.setSharedPixels(storage, storage->data(), t.width, t.height, t.channels, t.format);
+    }
+    m_lru.push_front(name);
+    entry.lruPosition = m_lru.begin();
+    m_bytes += entry.bytes;
+}
+
+void TextureManager::publishCurrent() {
+    std::shared_ptr<const CurrentTexture> snapshot;
+    if (currentTexture) {
+        auto current = std::make_shared<CurrentTexture>();
+        current->name = currentTextureName;
+        current->version = textures.at(currentTextureName).version;
+        current->texture = *currentTexture;
+        snapshot = std::move(current);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_currentMutex);
+        m_current.swap(snapshot);
+    }
+    m_generation.fetch_add(1, std::memory_order_release);
+    // The replaced snapshot, if the render loop is done with it, is freed here
+}
+
+std::shared_ptr<const TextureManager::CurrentTexture> TextureManager::getCurrent() const {
+    std::lock_guard<std::mutex> lock(m_currentMutex);
+    return m_current;
+}
+
+void TextureManager::touch(Entry& entry) {
+    m_lru.splice(m_lru.begin(), m_lru, entry.lruPosition);
+}
+
+void TextureManager::erase(std::map<std::string, Entry>::iterator it) {
+    m_bytes -= it->second.bytes;
+    m_lru.erase(it->second.lruPosition);
+    textures.erase(it);
+}
+
+void TextureManager::evictToBudget() {
+    // Walk from the least recently used end, skipping pinned images
+    auto pos = m_lru.end();
+    while (m_bytes > m_budgetBytes && pos != m_lru.begin()) {
+        auto candidate = std::prev(pos);
+        if (isPinned(*candidate)) {
+            pos = candidate;
+            continue;
         }
+        erase(textures.find(*candidate));
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
     }
 }
+
+bool TextureManager::isPinned(const std::string& name) const {
+    return name == currentTextureName || name == m_nextTextureName;
+}
+
+void TextureManager::updateCacheStats() {
+    m_cachedTextures.store(textures.size(), std::memory_order_relaxed);
+    m_cachedBytes.store(m_bytes, std::memory_order_relaxed);
+}
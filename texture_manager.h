@@ -1,25 +1,63 @@
 #pragma once
 #include "texture.h"
+#include "job_queue.h"
+#include "image_disk_cache.h"
+#include "media_index.h"
+#include <future>
 #include <map>
+#include <list>
 #include <string>
 #include <vector>
 #include <memory>
 #include <mutex>
-#include <chrono>
+#include <atomic>
+#include <cstdint>
 
+// Decoded still images, kept in an LRU cache bounded by decoded bytes.
+// The current texture and the next one (the most recently pre-loaded, or the
+// one after it in the prefetch schedule) are pinned and never evicted, even if
+// together they exceed the budget.
+//
+// Prefetched images decode in parallel on a small worker pool. A load that
+// finds its image still decoding waits for that decode instead of starting
+// another; a load of an image nobody is decoding runs on the caller's thread,
+// so it never queues behind prefetches.
+//
+// With a disk cache open, decoded images are also kept on the data partition
+// and later loads map them instead of decoding (see ImageDiskCache).
 class TextureManager {
 public:
+    static constexpr size_t DEFAULT_CACHE_BYTES = 256u * 1024 * 1024;
+    static constexpr int AUTO_PREFETCH_AHEAD = 2;   // schedule entries decoded ahead of the current one
+
     TextureManager();
     ~TextureManager();
 
-    // Scan directory for texture files
-    void scanTextureDirectory();
+    // Follow the media library: keep the list of images in step and drop
+    // cached decodes of files that were replaced or deleted. A replaced
+    // image on screen is decoded again and shown.
+    void applyMediaChange(const MediaIndex::Change& change);
 
-    // Load a specific texture by filename
+    // Load a specific texture by filename and pin it as the next texture.
+    // Decoding happens outside the lock, so the render loop is never held up.
     bool loadTexture(const std::string& filename);
 
-    // Get a safe copy of the current texture (thread-safe)
-    Texture getCurrentTextureCopy() const;
+    // The current texture as published to the render loop. Snapshots are
+    // immutable and replaced as a whole, so readers never take m_mutex,
+    // which decodes and cache updates can hold for a while.
+    struct CurrentTexture {
+        std::string name;
+        uint64_t version = 0;   // changes with every new decode of `name`
+        Texture texture;        // shares the cached pixels
+    };
+
+    // Bumped every time a new snapshot is published: one atomic load, cheap
+    // enough to poll every frame
+    uint64_t getCurrentGeneration() const { return m_generation.load(std::memory_order_acquire); }
+
+    // Latest snapshot; null when no texture is current. Takes a small lock
+    // held only to copy the pointer, so call it when the generation changes.
+    std::shared_ptr<const CurrentTexture> getCurrent() const;
 
     // Get current texture name
     std::string getCurrentTextureName() const;
@@ -27,6 +65,13 @@ public:
     // Set current texture by name (auto-loads if not in memory)
     bool setCurrentTexture(const std::string& name);
 
+    // setCurrentTexture split for the render thread: showResident() only
+    // switches to an image already in memory (e.g. pinned by loadTexture) and
+    // never touches the disk; prefetchAhead() then decodes ahead of it in the
+    // prefetch schedule, off the render thread
+    bool showResident(const std::string& name);
+    void prefetchAhead();
+
     // Get list of available texture names
     std::vector<std::string> getAvailableTextures() const;
 
@@ -36,17 +81,122 @@ public:
     // Unload all textures
     void unloadAll();
 
+    // Decode `names` in the background, in order, as the schedule of upcoming
+    // images. Once one of them is shown, the next AUTO_PREFETCH_AHEAD follow
+    // automatically. Entries are queued while the images fit in the cache
+    // budget; `queued` receives the ones that will be decoded, `skipped` the
+    // ones that are missing or would not fit.
+    void prefetch(const std::vector<std::string>& names,
+                  std::vector<std::string>& queued, std::vector<std::string>& skipped);
+
+    // Evicts least recently used images until the cache fits `bytes`
+    void setCacheBudget(size_t bytes);
+
+    // Keep display-ready copies of decoded images in `directory`, up to `maxBytes`
+    bool openDiskCache(const std::string& directory, size_t maxBytes);
+    ImageDiskCache::Stats getDiskCacheStats() const;
+
+    // Size images are decoded at (see IRenderer::getImageTargetSize); 0 x 0
+    // keeps full resolution. Cached images decoded for another size are
+    // dropped, except the pinned current and next ones. Returns whether the
+    // size changed; the current image then wants a reloadCurrent().
+    bool setTargetSize(int width, int height);
+
+    // Decode the current image again at the target size and show it.
+    // Blocks on the decode, so not for the render thread.
+    void reloadCurrent();
+
+    // Cache occupancy and counters. Lock-free, for metrics.
+    struct CacheStats {
+        size_t textures = 0;
+        size_t bytes = 0;
+        size_t budgetBytes = 0;
+        uint64_t hits = 0;        // loads served from memory
+        uint64_t misses = 0;      // loads that decoded from disk
+        uint64_t evictions = 0;
+        int decoding = 0;         // images being decoded or queued for decode
+    };
+    CacheStats getCacheStats() const;
+
+    struct CacheEntry {
+        std::string name;
+        int width = 0;
+        int height = 0;
+        size_t bytes = 0;
+        bool pinned = false;
+    };
+    // Cached images, most recently used first
+    std::vector<CacheEntry> getCacheEntries() const;
+
 private:
-    // Unload textures not used within the retention period (never the active one)
-    // Must be called with m_mutex held
-    void cleanupUnused();
+    struct Entry {
+        Texture texture;
+        size_t bytes = 0;
+        uint64_t version = 0;   // unique per decode
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    // Prefetch candidate with its decoded size read from the file header
+    struct PlannedDecode {
+        std::string name;
+        size_t bytes = 0;
+        bool found = false;
+    };
+
+    // Disk access; no lock held
+    bool decode(const std::string& name, int targetWidth, int targetHeight, Texture& texture);
+    static std::vector<PlannedDecode> probe(const std::vector<std::string>& names,
+                                            int targetWidth, int targetHeight);
+    static size_t decodedBytes(const Texture& texture);
+
+    // The following must be called with m_mutex held
+    // Make `name` resident, decoding it (lock released meanwhile) or waiting
+    // for a background decode. Returns with the lock held.
+    bool ensureLoaded(const std::string& name, std::unique_lock<std::mutex>& lock);
+    void queueDecodes(const std::vector<PlannedDecode>& plan,
+                      std::vector<std::string>& queued, std::vector<std::string>& skipped);
+    void insert(const std::string& name, Texture&& texture);
+    void makeCurrent(const std::string& name);
+    // Decode `name` (no lock held) and swap it in if it is still current
+    void redecodeCurrent(const std::string& name, int targetWidth, int targetHeight);
+    // Queue decodes of the schedule entries after `name`; releases the lock
+    // while reading file headers
+    void decodeAhead(const std::string& name, std::unique_lock<std::mutex>& lock);
+    void touch(Entry& entry);
+    void erase(std::map<std::string, Entry>::iterator it);
+    void evictToBudget();
+    bool isPinned(const std::string& name) const;
+    void updateCacheStats();
+    void publishCurrent();
 
     mutable std::mutex m_mutex;
-    std::map<std::string, Texture> textures;
-    std::map<std::string, std::chrono::steady_clock::time_point> lastUsed;
+    std::map<std::string, Entry> textures;
+    std::list<std::string> m_lru;   // most recently used first
     std::vector<std::string> availableTextures;
     Texture* currentTexture = nullptr;
     std::string currentTextureName;
+    uint64_t m_lastVersion = 0;
+    std::string m_nextTextureName;
+    size_t m_budgetBytes = DEFAULT_CACHE_BYTES;
+    size_t m_bytes = 0;
+    int m_targetWidth = 0;
+    int m_targetHeight = 0;
+    std::map<std::string, std::shared_future<bool>> m_decoding;   // in flight, by name
+    std::vector<std::string> m_schedule;                           // last prefetch list
+    bool m_stopping = false;
+
+    std::atomic<size_t> m_cachedTextures{0};
+    std::atomic<size_t> m_cachedBytes{0};
+    std::atomic<size_t> m_cacheBudget{DEFAULT_CACHE_BYTES};
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_evictions{0};
+    std::atomic<int> m_decodingCount{0};
+
+    mutable std::mutex m_currentMutex;   // guards m_current only
+    std::shared_ptr<const CurrentTexture> m_current;
+    std::atomic<uint64_t> m_generation{0};
 
-    static constexpr int TEXTURE_RETAIN_SECONDS = 30;
+    ImageDiskCache m_diskCache;
+    JobQueue m_decoders;
 };
@@ -22,33 +22,107 @@ extern "C" {
 #include <unistd.h>
 
 #include "log.h"
+#include "pixel_ops.h"
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <cmath>
 
 struct VideoDecoder::FFmpegContext {
     AVFormatContext* formatCtx = nullptr;
     AVCodecContext* codecCtx = nullptr;
     SwsContext* swsCtx = nullptr;
     AVFrame* frame = nullptr;
-    AVFrame* rgbaFrame = nullptr;
     AVPacket* packet = nullptr;
     int videoStreamIndex = -1;
     int lastPixFmt = -1;
     bool hwDecode = false;
     bool dmaBufFailed = false;
     double firstPts = -1.0;
-    uint8_t* rgbaBuffer = nullptr;
+
+    // Pooled single-block buffers for software-decoded YUV420P (see getBuffer)
+    AVBufferPool* framePool = nullptr;
+    size_t framePoolSize = 0;
+    std::mutex framePoolMutex;
+
+    static int getBuffer(AVCodecContext* ctx, AVFrame* frame, int flags);
 
     ~FFmpegContext() {
-        if (rgbaBuffer) av_free(rgbaBuffer);
-        if (rgbaFrame) av_frame_free(&rgbaFrame);
         if (frame) av_frame_free(&frame);
         if (packet) av_packet_free(&packet);
         if (swsCtx) sws_freeContext(swsCtx);
         if (codecCtx) avcodec_free_context(&codecCtx);
         if (formatCtx) avformat_close_input(&formatCtx);
+        // Buffers still referenced by queued frames keep the pool alive
+        av_buffer_pool_uninit(&framePool);
+    }
+};
+
+// get_buffer2 for software decode: allocate all three YUV420P planes in one
+// pooled, 64-byte aligned block. Decoded frames can then be handed to the
+// renderer by reference (Texture::planes) instead of copied.
+int VideoDecoder::FFmpegContext::getBuffer(AVCodecContext* ctx, AVFrame* frame, int flags) {
+    auto* ff = static_cast<FFmpegContext*>(ctx->opaque);
+    if (!ff || frame->format != AV_PIX_FMT_YUV420P || !(ctx->codec->capabilities & AV_CODEC_CAP_DR1))
+        return avcodec_default_get_buffer2(ctx, frame, flags);
+
+    int w = frame->width;
+    int h = frame->height;
+    int strideAlign[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(ctx, &w, &h, strideAlign);
+
+    int linesize[3];
+    size_t planeSize[3];
+    for (int i = 0; i < 3; i++) {
+        int pw = (i == 0) ? w : (w + 1) / 2;
+        int ph = (i == 0) ? h : (h + 1) / 2;
+        linesize[i] = FFALIGN(pw, std::max(64, strideAlign[i]));
+        planeSize[i] = (size_t)linesize[i] * ph;
+    }
+    size_t total = planeSize[0] + planeSize[1] + planeSize[2] + AV_INPUT_BUFFER_PADDING_SIZE;
+
+    AVBufferRef* buf = nullptr;
+    {
+        // Called from the codec's worker threads with frame threading
+        std::lock_guard<std::mutex> lock(ff->framePoolMutex);
+        if (!ff->framePool || ff->framePoolSize != total) {
+            av_buffer_pool_uninit(&ff->framePool);
+            ff->framePool = av_buffer_pool_init(total, nullptr);
+            ff->framePoolSize = total;
+        }
+        if (ff->framePool)
+            buf = av_buffer_pool_get(ff->framePool);
+    }
+    if (!buf) return AVERROR(ENOMEM);
+
+    frame->buf[0] = buf;
+    uint8_t* p = buf->data;
+    for (int i = 0; i < 3; i++) {
+        frame->data[i] = p;
+        frame->linesize[i] = linesize[i];
+        p += planeSize[i];
+    }
+    frame->extended_data = frame->data;
+    return 0;
+}
+
+// Keeps a referenced AVFrame alive for as long as any Texture copy uses it
+static std::shared_ptr<void> avFrameHolder(AVFrame* frame) {
+    return std::shared_ptr<void>(frame, [](void* p) {
+        AVFrame* f = static_cast<AVFrame*>(p);
+        av_frame_free(&f);
+    });
+}
+
+#ifdef __linux__
+// Owns the fds of an exported VA-API surface
+struct DmaBufFds {
+    std::vector<int> fds;
+    ~DmaBufFds() {
+        for (int fd : fds) ::close(fd);
     }
 };
+#endif
 
 VideoDecoder::VideoDecoder() {}
 
@@ -121,9 +195,64 @@ static std::string resolveHlsVariant(const std::string& url) {
     return url;
 }
 
+bool VideoDecoder::findKnownInfo(const std::string& path, MediaProbeCache::MediaInfo& info) const {
+    const std::string& directory = m_probeCache->directory();
+    if (path.compare(0, directory.size(), directory) != 0) return false;
+    std::string name = path.substr(directory.size());
+    if (name.find('/') != std::string::npos) return false;
+    return m_probeCache->find(name, info) && info.type == "video";
+}
+
+// Use indexed metadata in place of avformat_find_stream_info, if the header
+// the demuxer read agrees with it
+static bool applyKnownInfo(AVFormatContext* formatCtx, const MediaProbeCache::MediaInfo& info) {
+    int index = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (index < 0) return false;
+    AVStream* stream = formatCtx->streams[index];
+    if (stream->codecpar->width <= 0 || stream->codecpar->height <= 0 ||
+        stream->codecpar->width != info.width || stream->codecpar->height != info.height ||
+        info.codec != avcodec_get_name(stream->codecpar->codec_id)) {
+        return false;
+    }
+    if ((stream->avg_frame_rate.num <= 0 || stream->avg_frame_rate.den <= 0) && info.fps > 0)
+        stream->avg_frame_rate = av_d2q(info.fps, 100000);
+    if (formatCtx->duration <= 0 && info.duration > 0)
+        formatCtx->duration = static_cast<int64_t>(info.duration * AV_TIME_BASE);
+    return true;
+}
+
 bool VideoDecoder::open(const std::string& source) {
     close();
 
+    if (TestPatternSource::isTestSource(source)) {
+        TestPatternSource::Params params;
+        std::string error;
+        if (!TestPatternSource::parse(source, params, error)) {
+            std::cerr << "Invalid test pattern source: " << error << std::endl;
+            recordError("Invalid test pattern source: " + error);
+            return false;
+        }
+        m_source = source;
+        m_isStream = false;
+        m_timeBase = 1.0 / params.fps;
+        auto testSource = std::make_unique<TestPatternSource>(params);
+        testSource->setOnEndCallback([this] {
+            m_active = false;
+            if (m_onEndCallback)
+                m_onEndCallback();
+        });
+        {
+            std::lock_guard<std::mutex> lock(m_sourceMutex);
+            m_testSource = std::move(testSource);
+            m_sourceState.info = readSourceInfo();
+            m_sourceState.open = true;
+            m_sourceState.testPattern = true;
+        }
+        std::cout << "Opened test pattern: " << params.width << "x" << params.height
+                  << " @ " << params.fps << " fps" << std::endl;
+        return true;
+    }
+
     std::string resolvedSource = resolveHlsVariant(source);
     m_source = resolvedSource;
     m_isStream = resolvedSource.find("://") != std::string::npos;
@@ -147,12 +276,21 @@ bool VideoDecoder::open(const std::string& source) {
         char errbuf[256];
         av_strerror(ret, errbuf, sizeof(errbuf));
         std::cerr << "Failed to open video source: " << errbuf << std::endl;
+        recordError(std::string("Failed to open video source: ") + errbuf);
         m_ff.reset();
         return false;
     }
 
-    if (avformat_find_stream_info(m_ff->formatCtx, nullptr) < 0) {
+    // Known local files already carry what stream probing would find, which
+    // can take a while: avformat_find_stream_info decodes the first frames
+    MediaProbeCache::MediaInfo known;
+    bool useKnown = !m_isStream && m_probeCache && findKnownInfo(resolvedSource, known) &&
+                    applyKnownInfo(m_ff->formatCtx, known);
+    if (useKnown) {
+        LOG_DEBUG("Video: stream info for " << resolvedSource << " taken from the media index");
+    } else if (avformat_find_stream_info(m_ff->formatCtx, nullptr) < 0) {
         std::cerr << "Failed to find stream info" << std::endl;
+        recordError("Failed to find stream info");
         m_ff.reset();
         return false;
     }
@@ -161,6 +299,7 @@ bool VideoDecoder::open(const std::string& source) {
         m_ff->formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
     if (m_ff->videoStreamIndex < 0) {
         std::cerr << "No video stream found in source" << std::endl;
+        recordError("No video stream found in source");
         m_ff.reset();
         return false;
     }
@@ -202,6 +341,7 @@ bool VideoDecoder::open(const std::string& source) {
         codec = avcodec_find_decoder(stream->codecpar->codec_id);
         if (!codec) {
             std::cerr << "Unsupported codec: " << avcodec_get_name(stream->codecpar->codec_id) << std::endl;
+            recordError(std::string("Unsupported codec: ") + avcodec_get_name(stream->codecpar->codec_id));
             m_ff.reset();
             return false;
         }
@@ -209,8 +349,11 @@ bool VideoDecoder::open(const std::string& source) {
         avcodec_parameters_to_context(m_ff->codecCtx, stream->codecpar);
         m_ff->codecCtx->thread_count = 0;  // auto - use all cores
         m_ff->codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        m_ff->codecCtx->opaque = m_ff.get();
+        m_ff->codecCtx->get_buffer2 = FFmpegContext::getBuffer;
         if (avcodec_open2(m_ff->codecCtx, codec, nullptr) < 0) {
             std::cerr << "Failed to open codec" << std::endl;
+            recordError("Failed to open codec");
             m_ff.reset();
             return false;
         }
@@ -218,17 +361,15 @@ bool VideoDecoder::open(const std::string& source) {
     }
 
     m_ff->frame = av_frame_alloc();
-    m_ff->rgbaFrame = av_frame_alloc();
     m_ff->packet = av_packet_alloc();
 
-    int w = m_ff->codecCtx->width;
-    int h = m_ff->codecCtx->height;
-    int bufSize = av_image_get_buffer_size(AV_PIX_FMT_RGBA, w, h, 1);
-    m_ff->rgbaBuffer = (uint8_t*)av_malloc(bufSize);
-    av_image_fill_arrays(m_ff->rgbaFrame->data, m_ff->rgbaFrame->linesize,
-                         m_ff->rgbaBuffer, AV_PIX_FMT_RGBA, w, h, 1);
-
-    auto info = getSourceInfo();
+    auto info = readSourceInfo();
+    {
+        std::lock_guard<std::mutex> lock(m_sourceMutex);
+        m_sourceState.info = info;
+        m_sourceState.open = true;
+        m_sourceState.stream = m_isStream;
+    }
     std::cout << "Opened video: " << info.source
               << " (" << info.width << "x" << info.height
               << " @ " << info.fps << " fps"
@@ -244,23 +385,48 @@ bool VideoDecoder::open(const std::string& source) {
 
 void VideoDecoder::close() {
     stop();
+    std::unique_ptr<TestPatternSource> testSource;
+    {
+        std::lock_guard<std::mutex> lock(m_sourceMutex);
+        testSource = std::move(m_testSource);
+        m_sourceState = SourceState();
+    }
+    testSource.reset();
     m_ff.reset();
     m_source.clear();
     m_active = false;
 }
 
 void VideoDecoder::start() {
+    if (m_testSource) {
+        if (m_running) return;
+        m_running = true;
+        m_active = true;
+        m_testSource->start(m_frameQueue);
+        return;
+    }
     if (!m_ff || m_running) return;
     m_running = true;
     m_active = true;
     m_packetQueue.reset();
     m_packetQueue.timeBase = m_timeBase;
+    {
+        std::lock_guard<std::mutex> lock(m_seekMutex);
+        m_seekRequest = SeekRequest();
+        m_seekRequested = 0;
+    }
+    m_seekQueued = 0;
+    m_seekApplied = 0;
+    m_seekTarget = 0.0;
+    m_playbackTime = 0.0;
     m_readerThread = std::thread(&VideoDecoder::readerLoop, this);
     m_decoderThread = std::thread(&VideoDecoder::decoderLoop, this);
 }
 
 void VideoDecoder::stop() {
     m_running = false;
+    if (m_testSource)
+        m_testSource->stop();
     m_packetQueue.stop();
     m_frameQueue.stop();
     if (m_readerThread.joinable())
@@ -278,6 +444,8 @@ void VideoDecoder::PacketQueue::push(AVPacket* pkt) {
         if (stopped) { av_packet_free(&pkt); return; }
     }
     packets.push_back(pkt);
+    if (pkt) bytes.fetch_add(pkt->size, std::memory_order_relaxed);
+    depth.store((int)packets.size(), std::memory_order_relaxed);
     notEmpty.notify_one();
 }
 
@@ -287,6 +455,8 @@ AVPacket* VideoDecoder::PacketQueue::pop() {
     if (stopped && packets.empty()) return nullptr;
     AVPacket* pkt = packets.front();
     packets.pop_front();
+    if (pkt) bytes.fetch_sub(pkt->size, std::memory_order_relaxed);
+    depth.store((int)packets.size(), std::memory_order_relaxed);
     notFull.notify_one();
     return pkt;
 }
@@ -296,6 +466,8 @@ void VideoDecoder::PacketQueue::stop() {
     stopped = true;
     for (auto* pkt : packets) { if (pkt) av_packet_free(&pkt); }
     packets.clear();
+    depth = 0;
+    bytes = 0;
     notEmpty.notify_all();
     notFull.notify_all();
 }
@@ -314,9 +486,73 @@ void VideoDecoder::PacketQueue::reset() {
     std::lock_guard<std::mutex> lock(mutex);
     for (auto* pkt : packets) { if (pkt) av_packet_free(&pkt); }
     packets.clear();
+    depth = 0;
+    bytes = 0;
     stopped = false;
 }
 
+void VideoDecoder::PacketQueue::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto* pkt : packets) { if (pkt) av_packet_free(&pkt); }
+    packets.clear();
+    depth = 0;
+    bytes = 0;
+    notFull.notify_all();
+}
+
+bool VideoDecoder::seek(double seconds, std::string& error) {
+    // Holding the source lock keeps close() from running in between: a seek
+    // either lands on this source, or is discarded by the next start()
+    std::lock_guard<std::mutex> sourceLock(m_sourceMutex);
+    const SourceState& state = m_sourceState;
+    if (state.testPattern) {
+        error = "Test patterns cannot seek";
+        return false;
+    }
+    if (!state.open || !m_active) {
+        error = "No video playing";
+        return false;
+    }
+    if (state.stream) {
+        error = "Streams cannot seek";
+        return false;
+    }
+    if (seconds < 0.0 || (state.info.duration > 0 && seconds >= state.info.duration)) {
+        error = "Time is outside the video";
+        return false;
+    }
+
+    // The index lists keyframes from the file itself, which also covers
+    // containers without a seek index of their own. A full list may have been
+    // cut off at MAX_KEYFRAMES; past its end, the demuxer knows better.
+    double keyframe = -1.0;
+    MediaProbeCache::MediaInfo known;
+    if (m_probeCache && findKnownInfo(state.info.source, known) && !known.keyframes.empty()) {
+        bool truncated = known.keyframes.size() >= MediaProbeCache::MAX_KEYFRAMES;
+        auto it = std::upper_bound(known.keyframes.begin(), known.keyframes.end(), seconds);
+        if (it != known.keyframes.begin() && !(truncated && it == known.keyframes.end()))
+            keyframe = *std::prev(it);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_seekMutex);
+        m_seekRequest.id++;
+        m_seekRequest.target = seconds;
+        m_seekRequest.keyframe = keyframe;
+        m_seekRequested.store(m_seekRequest.id);
+    }
+    // Wake the reader if it is waiting for room in the packet queue
+    m_packetQueue.flush();
+    LOG_INFO("Video: seek to " << seconds << "s"
+             << (keyframe >= 0 ? " via indexed keyframe at " + std::to_string(keyframe) + "s" : std::string()));
+    return true;
+}
+
+void VideoDecoder::setPlaybackTime(double t, uint64_t seekGeneration) {
+    std::lock_guard<std::mutex> lock(m_playbackMutex);
+    if (seekGeneration == m_seekApplied.load()) m_playbackTime.store(t);
+}
+
 bool VideoDecoder::getFrameForTime(double mediaTime, Texture& outTexture) {
     return m_frameQueue.getFrameForTime(mediaTime, outTexture);
 }
@@ -325,13 +561,50 @@ bool VideoDecoder::getLatestFrame(Texture& outTexture) {
     return m_frameQueue.getLatest(outTexture);
 }
 
+VideoDecoder::Counters VideoDecoder::getCounters() const {
+    Counters c;
+    c.decodedFrames = m_frameQueue.totalPushed();
+    c.droppedFrames = m_frameQueue.droppedFrames();
+    c.frameQueueDepth = m_frameQueue.depth();
+    c.packetQueueDepth = m_packetQueue.depth.load(std::memory_order_relaxed);
+    c.packetQueueBytes = m_packetQueue.bytes.load(std::memory_order_relaxed);
+    return c;
+}
+
 bool VideoDecoder::isActive() const {
     return m_active;
 }
 
+void VideoDecoder::recordError(const std::string& message) {
+    std::lock_guard<std::mutex> lock(m_errorMutex);
+    m_lastError.message = message;
+    m_lastError.count++;
+}
+
+VideoDecoder::ErrorInfo VideoDecoder::getLastError() const {
+    std::lock_guard<std::mutex> lock(m_errorMutex);
+    return m_lastError;
+}
+
 VideoDecoder::SourceInfo VideoDecoder::getSourceInfo() const {
+    std::lock_guard<std::mutex> lock(m_sourceMutex);
+    return m_sourceState.info;
+}
+
+// Straight from the FFmpeg context; only on the thread that opens and closes
+VideoDecoder::SourceInfo VideoDecoder::readSourceInfo() const {
     SourceInfo info;
     info.source = m_source;
+    if (m_testSource) {
+        const auto& p = m_testSource->params();
+        info.width = p.width;
+        info.height = p.height;
+        info.fps = p.fps;
+        if (p.frameLimit > 0)
+            info.duration = p.frameLimit / p.fps;
+        info.codec = "testsrc";
+        return info;
+    }
     if (!m_ff || !m_ff->codecCtx) return info;
 
     info.width = m_ff->codecCtx->width;
@@ -350,6 +623,13 @@ VideoDecoder::SourceInfo VideoDecoder::getSourceInfo() const {
     return info;
 }
 
+bool VideoDecoder::getTestPatternStats(TestPatternSource::Stats& out) const {
+    std::lock_guard<std::mutex> lock(m_sourceMutex);
+    if (!m_testSource) return false;
+    out = m_testSource->getStats();
+    return true;
+}
+
 // Reader thread: reads packets from FFmpeg into the packet queue.
 // For streams: buffers ahead. For files: reads at decode rate (backpressure from packet queue).
 void VideoDecoder::readerLoop() {
@@ -382,7 +662,33 @@ void VideoDecoder::readerLoop() {
         LOG_INFO("Pre-buffered " << count << " packets");
     }
 
+    AVStream* stream = m_ff->formatCtx->streams[m_ff->videoStreamIndex];
+    int64_t streamStart = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    uint64_t seekHandled = 0;
+
     while (m_running) {
+        if (m_seekRequested.load() != seekHandled) {
+            SeekRequest request;
+            {
+                std::lock_guard<std::mutex> lock(m_seekMutex);
+                request = m_seekRequest;
+            }
+            seekHandled = request.id;
+            // An indexed keyframe is an exact landing point; otherwise let the
+            // demuxer find the keyframe before the target in its own index
+            double position = request.keyframe >= 0 ? request.keyframe : request.target;
+            int64_t timestamp = streamStart + (int64_t)std::llround(position / m_timeBase);
+            if (av_seek_frame(m_ff->formatCtx, m_ff->videoStreamIndex, timestamp, AVSEEK_FLAG_BACKWARD) < 0) {
+                LOG_WARN("Seek to " << position << "s failed, seeking to the start");
+                av_seek_frame(m_ff->formatCtx, m_ff->videoStreamIndex, streamStart, AVSEEK_FLAG_BACKWARD);
+            }
+            m_packetQueue.flush();
+            m_seekTarget.store(request.target);
+            m_seekQueued.store(request.id);
+            // Null packet: the decoder flushes and starts dropping up to the target
+            m_packetQueue.push(nullptr);
+        }
+
         AVPacket* pkt = av_packet_alloc();
         int ret = av_read_frame(m_ff->formatCtx, pkt);
         if (ret < 0) {
@@ -423,11 +729,18 @@ void VideoDecoder::decoderLoop() {
 
     int w = m_ff->codecCtx->width;
     int h = m_ff->codecCtx->height;
-    size_t rgbaSize = static_cast<size_t>(w) * h * 4;
 
     int decodedFrames = 0;
     auto lastDecoderLog = std::chrono::steady_clock::now();
 
+    // After a seek, frames ending before the target are discarded on arrival
+    AVStream* stream = m_ff->formatCtx->streams[m_ff->videoStreamIndex];
+    double streamStart = stream->start_time != AV_NOPTS_VALUE ? stream->start_time * m_timeBase : 0.0;
+    double frameDuration = stream->avg_frame_rate.num > 0 && stream->avg_frame_rate.den > 0
+                               ? av_q2d(av_inv_q(stream->avg_frame_rate)) : 0.0;
+    uint64_t seekApplied = 0;
+    double dropBefore = -1.0;
+
     while (m_running) {
         AVPacket* pkt = m_packetQueue.pop();
         static int popCount = 0;
@@ -435,9 +748,22 @@ void VideoDecoder::decoderLoop() {
         if (popCount <= 3) LOG_INFO("Decoder got packet #" << popCount << " pkt=" << (void*)pkt << " qsize=" << m_packetQueue.size());
         if (!pkt) {
             if (!m_running) break;
-            // Null packet = flush signal (file loop seek)
+            // Null packet = flush signal (file loop or seek)
             avcodec_flush_buffers(m_ff->codecCtx);
-            m_ff->firstPts = -1.0;
+            uint64_t seekQueued = m_seekQueued.load();
+            if (seekQueued != seekApplied) {
+                // Keep PTS relative to the file start, not the seek position
+                if (m_ff->firstPts < 0.0) m_ff->firstPts = streamStart;
+                dropBefore = m_seekTarget.load();
+                m_frameQueue.clear();
+                seekApplied = seekQueued;
+                std::lock_guard<std::mutex> lock(m_playbackMutex);
+                m_playbackTime = dropBefore;
+                m_seekApplied.store(seekApplied, std::memory_order_release);
+            } else {
+                m_ff->firstPts = -1.0;
+                dropBefore = -1.0;
+            }
             continue;
         }
 
@@ -448,6 +774,9 @@ void VideoDecoder::decoderLoop() {
             errCount++;
             if (errCount <= 5)
                 LOG_WARN("avcodec_send_packet error: " << ret);
+            char errbuf[256];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            recordError(std::string("Decode error: ") + errbuf);
             continue;
         }
 
@@ -463,6 +792,14 @@ void VideoDecoder::decoderLoop() {
                 pts = absPts - m_ff->firstPts;
             }
 
+            // Seeking: skip frames decoded from before the seek point, and the
+            // run-up from the keyframe to the target, before any conversion
+            if (m_seekRequested.load() != seekApplied) continue;
+            if (dropBefore >= 0.0) {
+                if (pts + frameDuration <= dropBefore + 0.001) continue;
+                dropBefore = -1.0;
+            }
+
 #ifdef __linux__
             // VA-API hw decode path
             if (m_ff->hwDecode && m_ff->frame->format == AV_PIX_FMT_VAAPI) {
@@ -487,17 +824,20 @@ void VideoDecoder::decoderLoop() {
                         dmaTex.width = w;
                         dmaTex.height = h;
                         dmaTex.format = ColorFormat::DMABUF_NV12;
-                        dmaTex.dmaFd = desc.objects[0].fd;
                         dmaTex.dmaFourcc = desc.fourcc;
-                        dmaTex.dmaOffset[0] = desc.layers[0].offset[0];
-                        dmaTex.dmaPitch[0] = desc.layers[0].pitch[0];
-                        if (desc.num_layers > 1) {
-                            dmaTex.dmaOffset[1] = desc.layers[1].offset[0];
-                            dmaTex.dmaPitch[1] = desc.layers[1].pitch[0];
-                        } else if (desc.layers[0].num_planes > 1) {
-                            dmaTex.dmaOffset[1] = desc.layers[0].offset[1];
-                            dmaTex.dmaPitch[1] = desc.layers[0].pitch[1];
+                        // Planes may live in separate objects (one fd each)
+                        int plane = 0;
+                        for (uint32_t l = 0; l < desc.num_layers; l++) {
+                            for (uint32_t p = 0; p < desc.layers[l].num_planes && plane < Texture::MAX_PLANES; p++) {
+                                int fd = desc.objects[desc.layers[l].object_index[p]].fd;
+                                dmaTex.setDmaPlane(plane++, fd, desc.layers[l].offset[p], desc.layers[l].pitch[p]);
+                            }
                         }
+                        // The fds are closed when the last copy of the frame is released
+                        auto fds = std::make_shared<DmaBufFds>();
+                        for (uint32_t i = 0; i < desc.num_objects; i++)
+                            fds->fds.push_back(desc.objects[i].fd);
+                        dmaTex.sharedStorage = fds;
                         m_frameQueue.push(pts, std::move(dmaTex));
                         exported = true;
                     } else {
@@ -508,22 +848,19 @@ void VideoDecoder::decoderLoop() {
                 }
 
                 if (!exported) {
-                    // Transfer to CPU, pass as NV12
+                    // Transfer to CPU and pass the NV12/P010 planes as-is
                     AVFrame* swFrame = av_frame_alloc();
-                    if (av_hwframe_transfer_data(swFrame, m_ff->frame, 0) == 0) {
-                        size_t ySize = (size_t)w * h;
-                        size_t uvSize = (size_t)w * (h / 2);
-                        std::vector<unsigned char> pixels(ySize + uvSize);
-                        for (int y = 0; y < h; y++)
-                            memcpy(pixels.data() + y * w, swFrame->data[0] + y * swFrame->linesize[0], w);
-                        for (int y = 0; y < h / 2; y++)
-                            memcpy(pixels.data() + ySize + y * w, swFrame->data[1] + y * swFrame->linesize[1], w);
-
+                    if (av_hwframe_transfer_data(swFrame, m_ff->frame, 0) == 0 &&
+                        (swFrame->format == AV_PIX_FMT_NV12 || swFrame->format == AV_PIX_FMT_P010)) {
+                        int depth = (swFrame->format == AV_PIX_FMT_P010) ? 10 : 8;
                         Texture nv12Tex;
-                        nv12Tex.setOwnedPixels(std::move(pixels), w, h, 1, ColorFormat::NV12);
+                        nv12Tex.setSharedPixels(avFrameHolder(swFrame), swFrame->data[0], w, h, 1, ColorFormat::NV12);
+                        nv12Tex.setPlane(0, 0, swFrame->linesize[0], depth);
+                        nv12Tex.setPlanePointer(1, swFrame->data[1], swFrame->linesize[1], depth);
                         m_frameQueue.push(pts, std::move(nv12Tex));
+                    } else {
+                        av_frame_free(&swFrame);
                     }
-                    av_frame_free(&swFrame);
                 }
                 continue;
             }
@@ -532,30 +869,32 @@ void VideoDecoder::decoderLoop() {
             // Software decode: pass YUV420P directly to GL shader (no sws_scale)
             AVFrame* srcFrame = m_ff->frame;
 
-            if (srcFrame->format == AV_PIX_FMT_YUV420P) {
-                // Convert planar YUV420P to Y + interleaved UV (NV12-like layout).
-                // This avoids needing a third texture which macOS GL driver optimizes out.
-                // Layout: Y(w*h) + UV interleaved (w/2 * h/2 * 2)
+            if (srcFrame->format == AV_PIX_FMT_YUV420P && m_planarOutput) {
+                // Reference the decoder's planes directly, no copy. The clone
+                // holds the buffers until the last Texture copy is gone.
+                AVFrame* ref = av_frame_clone(srcFrame);
+                if (!ref) continue;
+                Texture yuvTex;
+                yuvTex.setSharedPixels(avFrameHolder(ref), ref->data[0], w, h, 1, ColorFormat::YUV420P);
+                for (int i = 0; i < 3; i++)
+                    yuvTex.setPlanePointer(i, ref->data[i], ref->linesize[i]);
+                m_frameQueue.push(pts, std::move(yuvTex));
+            } else if (srcFrame->format == AV_PIX_FMT_YUV420P) {
+                // Renderer has no three-plane path: interleave U and V into an
+                // NV12-style plane. Layout: Y(w*h) + UV interleaved (w/2 * h/2 * 2)
                 size_t ySize = (size_t)w * h;
-                size_t uvSize = (size_t)(w / 2) * (h / 2) * 2; // interleaved UV pairs
-                std::vector<unsigned char> pixels(ySize + uvSize);
-
-                // Y plane
-                for (int y = 0; y < h; y++)
-                    memcpy(pixels.data() + y * w, srcFrame->data[0] + y * srcFrame->linesize[0], w);
-                // Interleave U and V into NV12-style UV plane
-                unsigned char* uvDst = pixels.data() + ySize;
-                for (int y = 0; y < h / 2; y++) {
-                    const unsigned char* uRow = srcFrame->data[1] + y * srcFrame->linesize[1];
-                    const unsigned char* vRow = srcFrame->data[2] + y * srcFrame->linesize[2];
-                    for (int x = 0; x < w / 2; x++) {
-                        *uvDst++ = uRow[x];
-                        *uvDst++ = vRow[x];
-                    }
-                }
+                size_t uvSize = (size_t)(w / 2) * (h / 2) * 2;
+                auto buf = m_framePool.acquire(ySize + uvSize);
+                unsigned char* pixels = buf->data();
+
+                PixelOps::copyPlane(pixels, w, srcFrame->data[0], srcFrame->linesize[0], w, h);
+                PixelOps::interleaveUV(pixels + ySize,
+                                       srcFrame->data[1], srcFrame->linesize[1],
+                                       srcFrame->data[2], srcFrame->linesize[2],
+                                       w / 2, h / 2);
 
                 Texture nv12Tex;
-                nv12Tex.setOwnedPixels(std::move(pixels), w, h, 1, ColorFormat::NV12);
+                nv12Tex.setSharedPixels(buf, pixels, w, h, 1, ColorFormat::NV12);
                 m_frameQueue.push(pts, std::move(nv12Tex));
             } else {
                 // Non-YUV420P: fall back to sws_scale to RGBA
@@ -569,23 +908,19 @@ void VideoDecoder::decoderLoop() {
                 }
                 if (!m_ff->swsCtx) continue;
 
+                // Scale straight into a pooled buffer; the renderer honours the padded pitch
+                int dstStride = FFALIGN(w * 4, 64);
+                auto buf = m_framePool.acquire((size_t)dstStride * h);
+                uint8_t* dstData[4] = { buf->data(), nullptr, nullptr, nullptr };
+                int dstLinesize[4] = { dstStride, 0, 0, 0 };
                 sws_scale(m_ff->swsCtx,
                           srcFrame->data, srcFrame->linesize,
                           0, h,
-                          m_ff->rgbaFrame->data, m_ff->rgbaFrame->linesize);
-
-                std::vector<unsigned char> pixels(rgbaSize);
-                int dstStride = w * 4;
-                if (m_ff->rgbaFrame->linesize[0] == dstStride) {
-                    memcpy(pixels.data(), m_ff->rgbaFrame->data[0], rgbaSize);
-                } else {
-                    for (int y = 0; y < h; y++)
-                        memcpy(pixels.data() + y * dstStride,
-                               m_ff->rgbaFrame->data[0] + y * m_ff->rgbaFrame->linesize[0], dstStride);
-                }
+                          dstData, dstLinesize);
 
                 Texture rgbaTex;
-                rgbaTex.setOwnedPixels(std::move(pixels), w, h, 4, ColorFormat::RGBA);
+                rgbaTex.setSharedPixels(buf, buf->data(), w, h, 4, ColorFormat::RGBA);
+                rgbaTex.setPlane(0, 0, dstStride);
                 m_frameQueue.push(pts, std::move(rgbaTex));
             } // end else (non-YUV420P)
 
@@ -604,7 +939,7 @@ void VideoDecoder::decoderLoop() {
             // Sleep until playback catches up.
             if (!m_isStream) {
                 double playback = m_playbackTime.load();
-                while (m_running && pts > playback + 1.0) {
+                while (m_running && pts > playback + 1.0 && m_seekRequested.load() == seekApplied) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(5));
                     playback = m_playbackTime.load();
                 }
@@ -13,181 +13,13 @@
 #include <unistd.h>
 #include "log.h"
 #include "texture.h"
+#include "frame_queue.h"
+#include "frame_pool.h"
+#include "test_pattern_source.h"
+#include "media_probe_cache.h"
 
 struct AVPacket;
 
-// Thread-safe ring buffer for decoded frames with PTS timestamps
-class FrameQueue {
-public:
-    static constexpr int CAPACITY = 180; // ~3s at 60fps - covers HLS segment gaps
-
-    struct Entry {
-        double pts = 0.0;
-        Texture frame;
-        bool valid = false;
-    };
-
-    // Push a frame. If blocking=true, waits when full (for file playback).
-    // If blocking=false, drops oldest when full (for live streams).
-    void push(double pts, Texture&& frame, bool blocking = false) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-
-        if (blocking && m_count >= CAPACITY) {
-            LOG_DEBUG("Queue BLOCKING (count=" << m_count << ")");
-            m_notFull.wait(lock, [this] { return m_count < CAPACITY || m_stopped; });
-            if (m_stopped) return;
-        } else if (!blocking && m_count >= CAPACITY) {
-            int oldestIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
-            auto& old = m_buffer[oldestIdx];
-            if (old.valid && old.frame.dmaFd >= 0)
-                ::close(old.frame.dmaFd);
-            old.valid = false;
-            m_count--;
-        }
-
-        auto& slot = m_buffer[m_writeIdx];
-        if (slot.valid && slot.frame.dmaFd >= 0)
-            ::close(slot.frame.dmaFd);
-        slot.pts = pts;
-        slot.frame = std::move(frame);
-        slot.valid = true;
-        m_writeIdx = (m_writeIdx + 1) % CAPACITY;
-        if (m_count < CAPACITY) m_count++;
-        m_totalPushed++;
-        if (m_totalPushed <= 10 || m_totalPushed % 1000 == 0)
-            LOG_DEBUG("Queue push #" << m_totalPushed << " pts=" << pts << " count=" << m_count << " blocking=" << blocking);
-    }
-
-    void stop() {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_stopped = true;
-        m_notFull.notify_all();
-    }
-
-    // Get the frame with PTS closest to but not after `time`.
-    // Drops older frames. Returns false if no frame available.
-    bool getFrameForTime(double time, Texture& out) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        if (m_count == 0) return false;
-
-        // Find the best frame: the one with PTS closest to but not after `time`
-        int bestIdx = -1;
-        double bestPts = -1e30;
-        int startIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
-
-        for (int i = 0; i < m_count; i++) {
-            int idx = (startIdx + i) % CAPACITY;
-            if (m_buffer[idx].valid && m_buffer[idx].pts <= time + 0.001 && m_buffer[idx].pts > bestPts) {
-                bestIdx = idx;
-                bestPts = m_buffer[idx].pts;
-            }
-        }
-
-        if (bestIdx < 0) return false;  // all frames in the future
-
-        out = m_buffer[bestIdx].frame;
-
-        // Drop all frames up to and including the one we picked
-        int dropped = 0;
-        while (m_count > 0) {
-            int oldestIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
-            auto& old = m_buffer[oldestIdx];
-            if (old.valid && old.frame.dmaFd >= 0)
-                ::close(old.frame.dmaFd);
-            old.valid = false;
-            m_count--;
-            dropped++;
-            if (oldestIdx == bestIdx) break;
-        }
-
-        if (dropped > 0) m_notFull.notify_one();
-        return true;
-    }
-
-    // Consume the next frame in order (for file playback with blocking queue)
-    bool getNext(Texture& out, double* outPts = nullptr) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        if (m_count == 0) return false;
-
-        int oldestIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
-        if (outPts) *outPts = m_buffer[oldestIdx].pts;
-        out = m_buffer[oldestIdx].frame;
-        m_buffer[oldestIdx].valid = false;
-        m_count--;
-        m_notFull.notify_one();
-        return true;
-    }
-
-    // Get the most recent frame (for live streams - always latest, drop rest)
-    bool getLatest(Texture& out) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        if (m_count == 0) return false;
-
-        int newestIdx = (m_writeIdx - 1 + CAPACITY) % CAPACITY;
-        out = m_buffer[newestIdx].frame;
-
-        int dropped = 0;
-        while (m_count > 1) {
-            int oldestIdx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
-            auto& old = m_buffer[oldestIdx];
-            if (old.valid && old.frame.dmaFd >= 0)
-                ::close(old.frame.dmaFd);
-            old.valid = false;
-            m_count--;
-            dropped++;
-        }
-
-        if (dropped > 0)
-            m_notFull.notify_one();
-
-        return true;
-    }
-
-    bool full() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_count >= CAPACITY;
-    }
-
-    // Block until there's space in the queue (for throttling the decoder)
-    void waitForSpace(std::atomic<bool>& running) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_notFull.wait(lock, [this, &running] { return m_count < CAPACITY / 2 || m_stopped || !running; });
-    }
-
-    bool empty() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_count == 0;
-    }
-
-    int size() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_count;
-    }
-
-    double oldestPts() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_count == 0) return -1.0;
-        int idx = (m_writeIdx - m_count + CAPACITY) % CAPACITY;
-        return m_buffer[idx].pts;
-    }
-
-    double newestPts() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_count == 0) return 0.0;
-        int idx = (m_writeIdx - 1 + CAPACITY) % CAPACITY;
-        return m_buffer[idx].pts;
-    }
-
-private:
-    mutable std::mutex m_mutex;
-    std::condition_variable m_notFull;
-    std::array<Entry, CAPACITY> m_buffer;
-    int m_writeIdx = 0;
-    int m_count = 0;
-    bool m_stopped = false;
-    int m_totalPushed = 0;
-};
-
 class VideoDecoder {
 public:
     VideoDecoder();
@@ -208,12 +40,34 @@ public:
 
     bool isActive() const;
     bool isStream() const { return m_isStream; }
+    bool isTestPattern() const { return m_testSource != nullptr; }
     int queueSize() const { return m_frameQueue.size(); }
     double oldestPts() const { return m_frameQueue.oldestPts(); }
-    void setPlaybackTime(double t) { m_playbackTime.store(t); }
+    // Media clock time of the render loop, which has seen the frames of
+    // seekGeneration() `seekGeneration`; reports from before a seek are ignored
+    void setPlaybackTime(double t, uint64_t seekGeneration = 0);
 
     void setLoop(bool loop) { m_loop = loop; }
 
+    // Jump to `seconds` from the start of a playing file. The reader seeks to
+    // the keyframe at or before it (from the media index, or the container's
+    // own index), and the decoder discards the frames leading up to it
+    // without converting them. Returns false with `error` set for streams,
+    // test patterns and out-of-range times.
+    bool seek(double seconds, std::string& error);
+
+    // Bumped once frames from a new seek position start arriving; the render
+    // loop restarts its media clock at seekPosition() when it changes
+    uint64_t seekGeneration() const { return m_seekApplied.load(std::memory_order_acquire); }
+    double seekPosition() const { return m_seekTarget.load(); }
+
+    // Local files the cache knows open without FFmpeg's stream probing
+    void setProbeCache(const MediaProbeCache* cache) { m_probeCache = cache; }
+
+    // Emit software-decoded YUV420P as three planes instead of repacking to NV12.
+    // Enable when the renderer supports it (IRenderer::supportsPlanarYUV).
+    void setPlanarOutput(bool enabled) { m_planarOutput = enabled; }
+
     using OnEndCallback = std::function<void()>;
     void setOnEndCallback(OnEndCallback cb) { m_onEndCallback = std::move(cb); }
 
@@ -225,17 +79,46 @@ public:
         std::string codec;
         std::string source;
     };
+    // Snapshot taken by open(), so it is safe to call while another thread
+    // opens or closes a source
     SourceInfo getSourceInfo() const;
 
+    // Pipeline counters for metrics. Lock-free, so reading them never
+    // contends with the reader, decoder or render threads.
+    struct Counters {
+        uint64_t decodedFrames = 0;    // frames queued for display since start
+        uint64_t droppedFrames = 0;    // frames discarded without being shown
+        int frameQueueDepth = 0;
+        int packetQueueDepth = 0;
+        int64_t packetQueueBytes = 0;  // compressed bytes waiting for the decoder
+    };
+    Counters getCounters() const;
+
     // Time base for PTS conversion (seconds per tick)
     double timeBase() const { return m_timeBase; }
 
+    // testsrc:// only: report the frame the render loop just presented
+    void onFramePresented(const Texture& frame) { if (m_testSource) m_testSource->onPresented(frame); }
+    bool getTestPatternStats(TestPatternSource::Stats& out) const;
+
+    // Most recent open or decode failure. `count` grows with every failure,
+    // so a repeat of the same error is still visible to pollers.
+    struct ErrorInfo {
+        std::string message;
+        uint64_t count = 0;
+    };
+    ErrorInfo getLastError() const;
+
 private:
+    void recordError(const std::string& message);
+    SourceInfo readSourceInfo() const;
+    bool findKnownInfo(const std::string& path, MediaProbeCache::MediaInfo& info) const;
     void readerLoop();   // reads packets from FFmpeg into packet queue
     void decoderLoop();  // decodes packets into frame queue
 
     struct FFmpegContext;
     std::unique_ptr<FFmpegContext> m_ff;
+    std::unique_ptr<TestPatternSource> m_testSource;
 
     std::thread m_readerThread;
     std::thread m_decoderThread;
@@ -252,23 +135,59 @@ private:
         bool stopped = false;
         double bufferedDuration = 0.0;
         double timeBase = 0.0;
+        // Mirrors of the queue's fill for lock-free metrics reads
+        std::atomic<int> depth{0};
+        std::atomic<int64_t> bytes{0};
 
         void push(AVPacket* pkt);
         AVPacket* pop();
         void stop();
         void reset();
+        void flush();   // drop queued packets, keep accepting new ones
         bool empty() const;
         int size() const;
     };
     PacketQueue m_packetQueue;
 
     FrameQueue m_frameQueue;
+    FramePool m_framePool;
+    std::atomic<bool> m_planarOutput{false};
     double m_timeBase = 0.0;
     bool m_isStream = false;
     std::atomic<double> m_playbackTime{0.0};
 
+    // Seeks: requested by seek(), positioned by the reader, applied by the
+    // decoder. Each stage publishes the request id it has reached.
+    struct SeekRequest {
+        uint64_t id = 0;
+        double target = 0.0;
+        double keyframe = -1.0;   // from the media index; -1 if unknown
+    };
+    std::mutex m_seekMutex;
+    SeekRequest m_seekRequest;
+    std::mutex m_playbackMutex;   // orders m_seekApplied against setPlaybackTime
+    std::atomic<uint64_t> m_seekRequested{0};
+    std::atomic<uint64_t> m_seekQueued{0};
+    std::atomic<uint64_t> m_seekApplied{0};
+    std::atomic<double> m_seekTarget{0.0};
+
     std::string m_source;
+
+    // What other threads may know about the open source; replaced by
+    // open() and close(). Also guards m_testSource for getTestPatternStats.
+    struct SourceState {
+        SourceInfo info;
+        bool open = false;
+        bool stream = false;
+        bool testPattern = false;
+    };
+    mutable std::mutex m_sourceMutex;
+    SourceState m_sourceState;
     bool m_loop = true;
+    const MediaProbeCache* m_probeCache = nullptr;
+
+    mutable std::mutex m_errorMutex;
+    ErrorInfo m_lastError;
     OnEndCallback m_onEndCallback;
 };
 
@@ -1,6 +1,9 @@
 #include "websocket_server.h"
 #include "splash_controller.h"
 #include "ndireceiver.h"
+#include "ndi_multiview.h"
+#include "ndisender.h"
+#include "preview_stream.h"
 #include "mdns_advertiser.h"
 #include "config.h"
 #ifdef HAVE_FFMPEG
@@ -9,7 +12,10 @@
 #endif
 #include <unistd.h>
 #include <algorithm>
-#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <sstream>
 
 namespace {
     // Reject path traversal attempts in filenames
@@ -31,9 +37,85 @@ namespace {
         if (source.rfind("srt://", 0) == 0) return true;
         if (source.rfind("http://", 0) == 0) return true;
         if (source.rfind("https://", 0) == 0) return true;
+        if (source.rfind("testsrc://", 0) == 0) return true;
         // For local paths, require safe filename (no traversal)
         return isSafeFilename(source);
     }
+
+    // State topics are polled and pushed as deltas (see pollState)
+    const char* const STATE_TOPICS[] = { "video", "playlist", "ndi", "errors", "stats" };
+    constexpr int STATE_POLL_MS = 250;
+    // A connection with more than this still unsent is skipped for a poll;
+    // its next delta then covers everything that changed meanwhile
+    constexpr size_t STATE_BACKLOG_BYTES = 64 * 1024;
+
+    bool isStateTopic(const std::string& topic) {
+        return std::find(std::begin(STATE_TOPICS), std::end(STATE_TOPICS), topic) != std::end(STATE_TOPICS);
+    }
+
+    // Topics clients can subscribe to for server-pushed events
+    bool isEventTopic(const std::string& topic) {
+        return topic == "ndi_sources" || topic == "media" || isStateTopic(topic);
+    }
+
+    // Members of `current` that differ from `previous`; removed members map to null
+    Json::Value diffObject(const Json::Value& previous, const Json::Value& current) {
+        Json::Value delta(Json::objectValue);
+        for (const auto& name : current.getMemberNames()) {
+            if (!previous.isMember(name) || previous[name] != current[name]) delta[name] = current[name];
+        }
+        for (const auto& name : previous.getMemberNames()) {
+            if (!current.isMember(name)) delta[name] = Json::nullValue;
+        }
+        return delta;
+    }
+
+    constexpr Json::ArrayIndex MAX_BATCH_COMMANDS = 32;
+    constexpr Json::ArrayIndex MAX_PREFETCH_TEXTURES = 64;
+
+    constexpr int DEFAULT_PREVIEW_FPS = 2;
+    constexpr int DEFAULT_PREVIEW_WIDTH = 320;
+    // A preview subscriber with more than this unsent skips images until it
+    // drains, so a slow link sees a lower rate instead of growing latency
+    constexpr size_t PREVIEW_BACKLOG_BYTES = 256 * 1024;
+
+    // Resident set size of this process, 0 if /proc is unavailable
+    uint64_t readResidentBytes() {
+        std::ifstream statm("/proc/self/statm");
+        uint64_t sizePages = 0, residentPages = 0;
+        if (!(statm >> sizePages >> residentPages)) return 0;
+        return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    // get_media_info entry; keyframe lists can be long, so only on request
+    Json::Value mediaInfoJson(const MediaProbeCache::MediaInfo& info, bool withKeyframes) {
+        Json::Value out;
+        out["name"] = info.name;
+        out["type"] = info.type;
+        out["size"] = static_cast<Json::Int64>(info.size);
+        out["hash"] = info.hash;
+        out["codec"] = info.codec;
+        out["width"] = info.width;
+        out["height"] = info.height;
+        if (info.type == "video") {
+            out["container"] = info.container;
+            out["fps"] = info.fps;
+            out["duration"] = info.duration;
+            out["keyframeCount"] = static_cast<Json::UInt64>(info.keyframes.size());
+            if (withKeyframes) {
+                out["keyframes"] = Json::arrayValue;
+                for (double time : info.keyframes) out["keyframes"].append(time);
+            }
+        }
+        return out;
+    }
+
+    // Result of a job that noticed a newer job of its kind while running
+    void markSuperseded(Json::Value& result) {
+        result["success"] = false;
+        result["cancelled"] = true;
+        result["message"] = "Superseded by a newer request";
+    }
 }
 
 WebSocketServer::WebSocketServer(TextureManager& tm, uint16_t port)
@@ -45,6 +127,7 @@ WebSocketServer::WebSocketServer(TextureManager& tm, uint16_t port)
     server.set_close_handler(bind(&WebSocketServer::onClose, this, std::placeholders::_1));
     server.set_message_handler(bind(&WebSocketServer::onMessage, this,
         std::placeholders::_1, std::placeholders::_2));
+    server.set_http_handler(bind(&WebSocketServer::onHttp, this, std::placeholders::_1));
 }
 
 WebSocketServer::~WebSocketServer() {
@@ -56,11 +139,21 @@ void WebSocketServer::start() {
         running = true;
         server.set_reuse_addr(true);
         server.listen(port);
+        m_stateTimer = std::make_unique<asio::steady_timer>(server.get_io_service());
+        scheduleStatePoll();
         serverThread = std::thread(&WebSocketServer::run, this);
     }
 }
 
 void WebSocketServer::stop() {
+    if (m_ndiReceiver) {
+        m_ndiReceiver->setOnSourcesChanged(nullptr);
+    }
+    if (m_previewStream) {
+        m_previewStream->setOnFrame(nullptr);
+        m_previewStream->setDemand(0, 0);
+    }
+    m_jobs.shutdown();
     if (running) {
         running = false;
         server.stop();
@@ -81,6 +174,47 @@ void WebSocketServer::run() {
     }
 }
 
+void WebSocketServer::setNDIReceiver(NDIReceiver* ndi) {
+    m_ndiReceiver = ndi;
+    if (!m_ndiReceiver) return;
+
+    m_ndiReceiver->setOnSourcesChanged([this](const std::vector<std::string>& appeared,
+                                              const std::vector<std::string>& disappeared) {
+        Json::Value event;
+        event["command"] = "ndi_sources_changed";
+        event["appeared"] = Json::arrayValue;
+        for (const auto& name : appeared) event["appeared"].append(name);
+        event["disappeared"] = Json::arrayValue;
+        for (const auto& name : disappeared) event["disappeared"].append(name);
+        event["sources"] = Json::arrayValue;
+        for (const auto& name : m_ndiReceiver->getAvailableSources()) event["sources"].append(name);
+        publish("ndi_sources", event);
+    });
+}
+
+void WebSocketServer::publishMediaChange(const MediaIndex::Change& change) {
+    auto names = [](const std::vector<std::string>& list) {
+        Json::Value array(Json::arrayValue);
+        for (const auto& name : list) array.append(name);
+        return array;
+    };
+    Json::Value event;
+    event["command"] = "media_changed";
+    event["added"] = names(change.added);
+    event["removed"] = names(change.removed);
+    event["modified"] = names(change.modified);
+    publish("media", event);
+}
+
+void WebSocketServer::setPreviewStream(PreviewStream* preview) {
+    m_previewStream = preview;
+    if (!m_previewStream) return;
+
+    m_previewStream->setOnFrame([this](const PreviewStream::Jpeg& jpeg, int, int) {
+        asio::post(server.get_io_service(), [this, jpeg] { deliverPreview(jpeg); });
+    });
+}
+
 void WebSocketServer::setConfiguration(Configuration* config) {
     m_config = config;
     if (m_config) {
@@ -126,23 +260,96 @@ void WebSocketServer::onOpen(websocketpp::connection_hdl hdl) {
 
 void WebSocketServer::onClose(websocketpp::connection_hdl hdl) {
     m_auth.onConnectionClosed(hdl);
+    m_subscriptions.erase(hdl);
+    if (m_previewClients.erase(hdl)) updatePreviewDemand();
 }
 
-std::vector<std::string> WebSocketServer::scanVideos() {
-    m_availableVideos.clear();
-    if (!std::filesystem::exists(MEDIA_PATH)) return m_availableVideos;
+void WebSocketServer::onHttp(websocketpp::connection_hdl hdl) {
+    auto con = server.get_con_from_hdl(hdl);
+    std::string resource = con->get_resource();
+    resource = resource.substr(0, resource.find('?'));
 
-    for (const auto& entry : std::filesystem::directory_iterator(MEDIA_PATH)) {
-        if (entry.is_regular_file()) {
-            std::string ext = entry.path().extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-            if (ext == ".mp4" || ext == ".mkv" || ext == ".mov" ||
-                ext == ".avi" || ext == ".webm" || ext == ".flv") {
-                m_availableVideos.push_back(entry.path().filename().string());
-            }
-        }
+    if (con->get_request().get_method() == "GET" && resource == "/metrics") {
+        con->set_status(websocketpp::http::status_code::ok);
+        con->append_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        con->set_body(metricsText());
+    } else {
+        con->set_status(websocketpp::http::status_code::not_found);
+        con->append_header("Content-Type", "text/plain; charset=utf-8");
+        con->set_body("Not found\n");
     }
-    return m_availableVideos;
+}
+
+std::string WebSocketServer::metricsText() const {
+    // Every source below is an atomic or a lock the render loop never takes,
+    // so a scrape cannot stall a frame
+    std::ostringstream out;
+    out << std::setprecision(15);
+    auto metric = [&out](const char* name, const char* type, const char* help, double value) {
+        out << "# HELP rendermatic_" << name << ' ' << help << '\n'
+            << "# TYPE rendermatic_" << name << ' ' << type << '\n'
+            << "rendermatic_" << name << ' ' << value << '\n';
+    };
+
+    if (m_renderStats) {
+        auto render = m_renderStats->snapshot();
+        metric("render_fps", "gauge", "Frames rendered per second over the last second.", render.fps);
+        metric("render_frame_time_ms", "gauge", "Average time to produce a frame over the last second, excluding the frame cap sleep.", render.frameTimeMsAvg);
+        metric("render_frame_time_max_ms", "gauge", "Longest frame over the last second.", render.frameTimeMsMax);
+        metric("render_frames_total", "counter", "Frames rendered since start.", static_cast<double>(render.frames));
+        metric("render_late_frames_total", "counter", "Frames that overran the frame budget.", static_cast<double>(render.lateFrames));
+        metric("present_seconds_total", "counter", "Time spent presenting frames (swap or page flip).", render.presentSeconds);
+        metric("presents_total", "counter", "Frames presented.", static_cast<double>(render.presents));
+    }
+
+#ifdef HAVE_FFMPEG
+    if (m_videoDecoder) {
+        auto video = m_videoDecoder->getCounters();
+        metric("decoder_frames_total", "counter", "Video frames decoded and queued for display.", static_cast<double>(video.decodedFrames));
+        metric("decoder_dropped_frames_total", "counter", "Decoded frames discarded without being shown.", static_cast<double>(video.droppedFrames));
+        metric("frame_queue_depth", "gauge", "Decoded frames waiting for display.", video.frameQueueDepth);
+        metric("packet_queue_depth", "gauge", "Compressed packets waiting for the decoder.", video.packetQueueDepth);
+        metric("packet_queue_bytes", "gauge", "Compressed bytes waiting for the decoder.", static_cast<double>(video.packetQueueBytes));
+    }
+#endif
+
+    auto cache = textureManager.getCacheStats();
+    metric("texture_cache_textures", "gauge", "Decoded images held in memory.", static_cast<double>(cache.textures));
+    metric("texture_cache_bytes", "gauge", "Memory used by decoded images.", static_cast<double>(cache.bytes));
+    metric("texture_cache_budget_bytes", "gauge", "Memory budget for decoded images.", static_cast<double>(cache.budgetBytes));
+    metric("texture_cache_hits_total", "counter", "Image lookups served from memory.", static_cast<double>(cache.hits));
+    metric("texture_cache_misses_total", "counter", "Image lookups that decoded from disk.", static_cast<double>(cache.misses));
+    metric("texture_cache_evictions_total", "counter", "Images evicted to stay within the budget.", static_cast<double>(cache.evictions));
+
+    auto disk = textureManager.getDiskCacheStats();
+    metric("image_disk_cache_entries", "gauge", "Decoded images stored on the data partition.", static_cast<double>(disk.entries));
+    metric("image_disk_cache_bytes", "gauge", "Data partition space used by decoded images.", static_cast<double>(disk.bytes));
+    metric("image_disk_cache_hits_total", "counter", "Image decodes replaced by mapping a stored copy.", static_cast<double>(disk.hits));
+    metric("image_disk_cache_misses_total", "counter", "Image decodes with no stored copy.", static_cast<double>(disk.misses));
+    metric("image_disk_cache_evictions_total", "counter", "Stored images deleted to stay within the size cap.", static_cast<double>(disk.evictions));
+    if (m_probeCache) {
+        auto probes = m_probeCache->getStats();
+        metric("media_info_entries", "gauge", "Media files with indexed metadata.", static_cast<double>(probes.entries));
+        metric("media_info_queued", "gauge", "Media files waiting to be probed.", static_cast<double>(probes.queued));
+        metric("media_info_probes_total", "counter", "Media files probed for metadata.", static_cast<double>(probes.probes));
+        metric("media_info_probe_failures_total", "counter", "Media files that could not be probed.", static_cast<double>(probes.failures));
+    }
+
+    if (m_ndiReceiver) {
+        bool connected = m_ndiReceiver->isConnected();
+        auto ndi = m_ndiReceiver->getStats();
+        metric("ndi_connected", "gauge", "1 while the NDI receiver is connected to a source.", connected ? 1 : 0);
+        metric("ndi_fps", "gauge", "NDI frames received per second over the last second.", connected ? ndi.fps : 0.0);
+        metric("ndi_frames_total", "counter", "NDI video frames received on the current connection.", static_cast<double>(ndi.framesReceived));
+        metric("ndi_dropped_frames_total", "counter", "NDI video frames the sender reports as dropped on the current connection.", static_cast<double>(ndi.framesDropped));
+    }
+    if (m_ndiSender) {
+        metric("ndi_output_connections", "gauge", "Receivers connected to the NDI program output.", m_ndiSender->connections());
+        metric("ndi_output_frames_total", "counter", "Frames sent on the NDI program output.", static_cast<double>(m_ndiSender->framesSent()));
+    }
+
+    metric("process_resident_memory_bytes", "gauge", "Resident memory size in bytes.", static_cast<double>(readResidentBytes()));
+    return out.str();
 }
 
 void WebSocketServer::sendJson(websocketpp::connection_hdl hdl, const Json::Value& response) {
@@ -150,6 +357,414 @@ void WebSocketServer::sendJson(websocketpp::connection_hdl hdl, const Json::Valu
     server.send(hdl, writer.write(response), websocketpp::frame::opcode::text);
 }
 
+void WebSocketServer::sendJsonAsync(websocketpp::connection_hdl hdl, const Json::Value& response) {
+    Json::FastWriter writer;
+    std::string payload = writer.write(response);
+    asio::post(server.get_io_service(), [this, hdl, payload] {
+        websocketpp::lib::error_code ec;  // the connection may have closed meanwhile
+        server.send(hdl, payload, websocketpp::frame::opcode::text, ec);
+    });
+}
+
+void WebSocketServer::submitJob(websocketpp::connection_hdl hdl, const std::string& command,
+                                const std::string& key, JobWork work, JobCommit commit) {
+    std::string responseCommand = command + "_response";
+    uint64_t id = m_jobs.submit(key,
+        [this, hdl, responseCommand, work, commit](uint64_t id, const std::atomic<bool>& cancelled) {
+            Json::Value result;
+            result["command"] = responseCommand;
+            result["jobId"] = static_cast<Json::UInt64>(id);
+            work(cancelled, result);
+            asio::post(server.get_io_service(), [this, hdl, result, commit] {
+                if (commit) commit(result);
+                Json::FastWriter writer;
+                websocketpp::lib::error_code ec;
+                server.send(hdl, writer.write(result), websocketpp::frame::opcode::text, ec);
+            });
+        },
+        [this, hdl, responseCommand](uint64_t id, uint64_t supersededBy) {
+            Json::Value result;
+            result["command"] = responseCommand;
+            result["jobId"] = static_cast<Json::UInt64>(id);
+            result["success"] = false;
+            result["cancelled"] = true;
+            result["message"] = supersededBy ? "Superseded by job " + std::to_string(supersededBy)
+                                             : std::string("Server shutting down");
+            sendJsonAsync(hdl, result);
+        });
+
+    Json::Value accepted;
+    accepted["command"] = "accepted";
+    accepted["request"] = command;
+    accepted["jobId"] = static_cast<Json::UInt64>(id);
+    accepted["success"] = true;
+    sendJson(hdl, accepted);
+}
+
+bool WebSocketServer::buildBatchStep(const Json::Value& request, BatchStep& step, std::string& error) {
+    std::string command = request["command"].asString();
+    step.command = command;
+
+    if (command == "set_texture") {
+        std::string textureName = request["texture"].asString();
+        if (!isSafeFilename(textureName)) {
+            error = "Invalid texture filename";
+            return false;
+        }
+        step.prepare = [this, textureName](std::string& err) {
+            if (textureManager.loadTexture(textureName)) return true;
+            err = "Failed to load texture";
+            return false;
+        };
+        // Pinned as the next texture by loadTexture, so showing it is a swap
+        step.apply = [this, textureName](Json::Value& result) {
+            result["success"] = textureManager.showResident(textureName);
+        };
+        step.finish = [this] { textureManager.prefetchAhead(); };
+    }
+    else if (command == "set_rotation") {
+        int angle = request.get("angle", 0).asInt();
+        if (angle != 0 && angle != 90 && angle != 180 && angle != 270) {
+            error = "Invalid angle. Must be 0, 90, 180, or 270.";
+            return false;
+        }
+        auto resized = std::make_shared<bool>(false);
+        step.apply = [this, angle, resized](Json::Value& result) {
+            *resized = applyRotation(angle);
+            result["success"] = true;
+            result["angle"] = angle;
+        };
+        // The image on screen was decoded for the old orientation
+        step.finish = [this, resized] {
+            if (*resized) textureManager.reloadCurrent();
+        };
+        step.commit = [this, angle] { m_config->displayRotation = angle; };
+    }
+    else if (command == "identify") {
+        if (!m_splashController) {
+            error = "Splash controller not available";
+            return false;
+        }
+        int duration = std::clamp(request.get("duration", 10).asInt(), 1, 60);
+        step.apply = [this, duration](Json::Value& result) {
+            m_splashController->trigger(duration);
+            result["success"] = true;
+            result["duration"] = duration;
+        };
+    }
+    else if (command == "set_ndi_source") {
+        if (!m_ndiReceiver || !m_ndiReceiver->isRuntimeLoaded()) {
+            error = "NDI runtime not installed. Place libndi.so in /data/lib/";
+            return false;
+        }
+        if (!request.isMember("source")) {
+            error = "Missing 'source' field";
+            return false;
+        }
+        std::string source = request["source"].asString();
+        step.stage = [this, source] {
+            m_ndiReceiver->setSource(source);
+            if (!m_ndiReceiver->isConnected()) {
+                m_ndiReceiver->start();
+            }
+        };
+        step.apply = [source](Json::Value& result) {
+            result["success"] = true;
+            result["source"] = source;
+        };
+        step.commit = [this, source] {
+            m_config->ndiSourceName = source;
+            m_config->ndiMode = true;
+        };
+    }
+    else if (command == "stop_ndi") {
+        if (!m_ndiReceiver) {
+            error = "NDI receiver not available";
+            return false;
+        }
+        step.apply = [this](Json::Value& result) {
+            m_ndiReceiver->requestStop();
+            result["success"] = true;
+        };
+        step.commit = [this] { m_config->ndiMode = false; };
+    }
+#ifdef HAVE_FFMPEG
+    else if (command == "stop_video") {
+        if (!m_videoDecoder) {
+            error = "Video decoder not available";
+            return false;
+        }
+        step.video = true;
+        step.stage = [this] {
+            m_videoDecoder->stop();
+            m_videoDecoder->close();
+        };
+        step.apply = [](Json::Value& result) { result["success"] = true; };
+        step.commit = [this] { m_config->videoMode = false; };
+    }
+    else if (command == "stop_playlist") {
+        if (!m_playlistController) {
+            error = "Playlist controller not available";
+            return false;
+        }
+        step.video = true;
+        step.stage = [this] { m_playlistController->stop(); };
+        step.apply = [](Json::Value& result) { result["success"] = true; };
+        step.commit = [this] { m_config->videoMode = false; };
+    }
+#endif
+    else {
+        error = "Command cannot be batched";
+        return false;
+    }
+    return true;
+}
+
+void WebSocketServer::runBatch(std::vector<BatchStep>& steps, const std::atomic<bool>& cancelled,
+                               Json::Value& result) {
+    result["results"] = Json::arrayValue;
+
+    // Slow preparation (image decoding) happens here, off the render thread
+    for (size_t i = 0; i < steps.size(); i++) {
+        std::string error;
+        if (steps[i].prepare && !steps[i].prepare(error)) {
+            result["success"] = false;
+            result["message"] = "Command " + std::to_string(i) + " (" + steps[i].command + "): " + error
+                              + "; nothing was applied";
+            return;
+        }
+    }
+    if (cancelled) {
+        markSuperseded(result);
+        return;
+    }
+    // Stopping the decoder joins its threads; that is not for the render thread
+    for (auto& step : steps) {
+        if (step.stage) step.stage();
+    }
+
+    // Apply every step between two frames
+    Json::Value results(Json::arrayValue);
+    auto apply = [&steps, &results] {
+        for (auto& step : steps) {
+            Json::Value stepResult;
+            stepResult["command"] = step.command;
+            step.apply(stepResult);
+            results.append(stepResult);
+        }
+    };
+    if (m_frameBoundary) {
+        std::promise<void> applied;
+        m_frameBoundary->post([&apply, &applied] {
+            apply();
+            applied.set_value();
+        });
+        applied.get_future().wait();
+    } else {
+        apply();
+    }
+
+    for (auto& step : steps) {
+        if (step.finish) step.finish();
+    }
+
+    bool success = true;
+    for (const auto& stepResult : results) success = success && stepResult["success"].asBool();
+    result["results"] = results;
+    result["success"] = success;
+}
+
+void WebSocketServer::addVideoStatus(Json::Value& out, bool withTestPattern) const {
+#ifdef HAVE_FFMPEG
+    if (m_videoDecoder) {
+        out["active"] = m_videoDecoder->isActive();
+        auto info = m_videoDecoder->getSourceInfo();
+        out["source"] = info.source;
+        out["width"] = info.width;
+        out["height"] = info.height;
+        out["fps"] = info.fps;
+        out["duration"] = info.duration;
+        out["codec"] = info.codec;
+        TestPatternSource::Stats stats;
+        if (withTestPattern && m_videoDecoder->getTestPatternStats(stats)) {
+            Json::Value tp;
+            tp["generated"] = static_cast<Json::UInt64>(stats.generated);
+            tp["presented"] = static_cast<Json::UInt64>(stats.presented);
+            tp["repeated"] = static_cast<Json::UInt64>(stats.repeated);
+            tp["dropped"] = static_cast<Json::UInt64>(stats.dropped);
+            tp["latencyMsAvg"] = stats.latencyMsAvg;
+            tp["latencyMsMax"] = stats.latencyMsMax;
+            out["testPattern"] = tp;
+        }
+        return;
+    }
+#else
+    (void)withTestPattern;
+#endif
+    out["active"] = false;
+}
+
+void WebSocketServer::addPlaylistStatus(Json::Value& out) const {
+#ifdef HAVE_FFMPEG
+    if (m_playlistController) {
+        out["active"] = m_playlistController->isActive();
+        out["currentIndex"] = m_playlistController->getCurrentIndex();
+        out["currentSource"] = m_playlistController->getCurrentSource();
+        out["loop"] = m_playlistController->isLooping();
+        out["videos"] = Json::arrayValue;
+        for (const auto& v : m_playlistController->getPlaylist()) {
+            out["videos"].append(v);
+        }
+        return;
+    }
+#endif
+    out["active"] = false;
+}
+
+void WebSocketServer::addNdiStatus(Json::Value& out) const {
+    if (m_ndiReceiver) {
+        out["connected"] = m_ndiReceiver->isConnected();
+        out["source"] = m_ndiReceiver->getCurrentSourceName();
+        out["frameSync"] = m_ndiReceiver->isFrameSyncActive();
+    } else {
+        out["connected"] = false;
+        out["source"] = "";
+        out["frameSync"] = false;
+    }
+}
+
+Json::Value WebSocketServer::stateSnapshot(const std::string& topic) const {
+    Json::Value state(Json::objectValue);
+    if (topic == "video") {
+        addVideoStatus(state, false);   // test-pattern counters change every frame
+    } else if (topic == "playlist") {
+        addPlaylistStatus(state);
+    } else if (topic == "ndi") {
+        addNdiStatus(state);
+    } else if (topic == "errors") {
+#ifdef HAVE_FFMPEG
+        if (m_videoDecoder) {
+            auto error = m_videoDecoder->getLastError();
+            Json::Value decoder;
+            decoder["message"] = error.message;
+            decoder["count"] = static_cast<Json::UInt64>(error.count);
+            state["decoder"] = decoder;
+        }
+#endif
+    } else if (topic == "stats") {
+        if (m_renderStats) {
+            auto render = m_renderStats->snapshot();
+            state["renderFps"] = render.fps;
+            state["frameTimeMsAvg"] = render.frameTimeMsAvg;
+            state["frameTimeMsMax"] = render.frameTimeMsMax;
+            state["lateFrames"] = static_cast<Json::UInt64>(render.lateFrames);
+        }
+        if (m_ndiReceiver && m_ndiReceiver->isConnected()) {
+            auto ndi = m_ndiReceiver->getStats();
+            state["ndiFps"] = ndi.fps;
+            state["ndiFramesDropped"] = static_cast<Json::Int64>(ndi.framesDropped);
+        }
+    }
+    return state;
+}
+
+void WebSocketServer::scheduleStatePoll() {
+    m_stateTimer->expires_after(std::chrono::milliseconds(STATE_POLL_MS));
+    m_stateTimer->async_wait([this](const std::error_code& ec) {
+        if (ec || !running) return;
+        pollState();
+        scheduleStatePoll();
+    });
+}
+
+void WebSocketServer::pollState() {
+    // Snapshot each topic at most once per poll, and only if someone wants it
+    std::map<std::string, Json::Value> current;
+    for (auto& [hdl, subscriber] : m_subscriptions) {
+        for (const auto& topic : subscriber.topics) {
+            if (isStateTopic(topic) && !current.count(topic)) current[topic] = stateSnapshot(topic);
+        }
+    }
+    if (current.empty()) return;
+
+    Json::FastWriter writer;
+    for (auto& [hdl, subscriber] : m_subscriptions) {
+        websocketpp::lib::error_code ec;
+        auto con = server.get_con_from_hdl(hdl, ec);
+        if (ec || con->get_buffered_amount() > STATE_BACKLOG_BYTES) continue;
+
+        // All of this connection's changed topics go out in one message
+        Json::Value changes(Json::objectValue);
+        for (const auto& topic : subscriber.topics) {
+            auto state = current.find(topic);
+            if (state == current.end()) continue;
+            Json::Value& sent = subscriber.sent[topic];
+            Json::Value delta = diffObject(sent, state->second);
+            if (delta.empty()) continue;
+            changes[topic] = delta;
+            sent = state->second;
+        }
+        if (changes.empty()) continue;
+
+        Json::Value event;
+        event["command"] = "state_changed";
+        event["changes"] = changes;
+        server.send(hdl, writer.write(event), websocketpp::frame::opcode::text, ec);
+    }
+}
+
+void WebSocketServer::updatePreviewDemand() {
+    if (!m_previewStream) return;
+    int fps = 0;
+    int width = 0;
+    for (const auto& [hdl, client] : m_previewClients) {
+        fps = std::max(fps, client.fps);
+        width = std::max(width, client.width);
+    }
+    m_previewStream->setDemand(fps, width);
+}
+
+bool WebSocketServer::applyRotation(int angle) {
+    if (!m_renderer) return false;
+    m_renderer->setRotation(angle);
+    int imageWidth = 0;
+    int imageHeight = 0;
+    m_renderer->getImageTargetSize(imageWidth, imageHeight);
+    return textureManager.setTargetSize(imageWidth, imageHeight);
+}
+
+void WebSocketServer::deliverPreview(const std::shared_ptr<const std::string>& jpeg) {
+    auto now = std::chrono::steady_clock::now();
+    for (auto& [hdl, client] : m_previewClients) {
+        if (now < client.nextFrame) continue;
+        websocketpp::lib::error_code ec;
+        auto con = server.get_con_from_hdl(hdl, ec);
+        if (ec) continue;
+        if (con->get_buffered_amount() > PREVIEW_BACKLOG_BYTES) {
+            client.framesDropped++;
+            continue;
+        }
+        server.send(hdl, jpeg->data(), jpeg->size(), websocketpp::frame::opcode::binary, ec);
+        if (ec) continue;
+        client.framesSent++;
+        // A little early is fine: the stream's own clock jitters by a frame
+        auto interval = std::chrono::microseconds(1000000 / client.fps);
+        client.nextFrame = now + interval - interval / 4;
+    }
+}
+
+void WebSocketServer::publish(const std::string& topic, const Json::Value& event) {
+    Json::FastWriter writer;
+    std::string payload = writer.write(event);
+    asio::post(server.get_io_service(), [this, topic, payload] {
+        for (const auto& [hdl, subscriber] : m_subscriptions) {
+            if (subscriber.topics.count(topic) == 0) continue;
+            websocketpp::lib::error_code ec;
+            server.send(hdl, payload, websocketpp::frame::opcode::text, ec);
+        }
+    });
+}
+
 void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::message_ptr msg) {
     Json::Value root;
     Json::Reader reader;
@@ -229,13 +844,16 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
     // --- Commands (requires authentication when auth is enabled) ---
 
     if (command == "scan_textures") {
-        textureManager.scanTextureDirectory();
-        response["command"] = "scan_textures_response";
-        response["textures"] = Json::arrayValue;
-        for (const auto& texture : textureManager.getAvailableTextures()) {
-            response["textures"].append(texture);
-        }
-        response["success"] = true;
+        // One rescan covers both lists, so the two scans share a key
+        submitJob(hdl, command, "scan", [this](const std::atomic<bool>&, Json::Value& result) {
+            if (m_mediaIndex) m_mediaIndex->rescan();
+            result["textures"] = Json::arrayValue;
+            for (const auto& texture : textureManager.getAvailableTextures()) {
+                result["textures"].append(texture);
+            }
+            result["success"] = true;
+        });
+        return;
     }
     else if (command == "list_textures") {
         response["command"] = "texture_list";
@@ -246,19 +864,27 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
         response["success"] = true;
     }
     else if (command == "scan_videos") {
-        auto videos = scanVideos();
-        response["command"] = "scan_videos_response";
-        response["videos"] = Json::arrayValue;
-        for (const auto& video : videos) {
-            response["videos"].append(video);
-        }
-        response["success"] = true;
+        // The rescan walks the directory and runs the change callbacks, which
+        // may decode a replaced image on screen
+        submitJob(hdl, command, "scan", [this](const std::atomic<bool>&, Json::Value& result) {
+            result["videos"] = Json::arrayValue;
+            if (m_mediaIndex) {
+                m_mediaIndex->rescan();
+                for (const auto& video : m_mediaIndex->getVideos()) {
+                    result["videos"].append(video);
+                }
+            }
+            result["success"] = true;
+        });
+        return;
     }
     else if (command == "list_videos") {
         response["command"] = "video_list";
         response["videos"] = Json::arrayValue;
-        for (const auto& video : m_availableVideos) {
-            response["videos"].append(video);
+        if (m_mediaIndex) {
+            for (const auto& video : m_mediaIndex->getVideos()) {
+                response["videos"].append(video);
+            }
         }
         response["success"] = true;
     }
@@ -269,7 +895,11 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
             response["success"] = false;
             response["message"] = "Invalid texture filename";
         } else {
-            response["success"] = textureManager.loadTexture(textureName);
+            submitJob(hdl, command, "load_texture:" + textureName,
+                      [this, textureName](const std::atomic<bool>&, Json::Value& result) {
+                result["success"] = textureManager.loadTexture(textureName);
+            });
+            return;
         }
     }
     else if (command == "set_texture") {
@@ -279,7 +909,127 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
             response["success"] = false;
             response["message"] = "Invalid texture filename";
         } else {
-            response["success"] = textureManager.setCurrentTexture(textureName);
+            // Decoding happens before the switch, so a newer set_texture that
+            // arrives meanwhile still wins
+            submitJob(hdl, command, "set_texture",
+                      [this, textureName](const std::atomic<bool>& cancelled, Json::Value& result) {
+                if (!textureManager.loadTexture(textureName)) {
+                    result["success"] = false;
+                } else if (cancelled) {
+                    markSuperseded(result);
+                } else {
+                    result["success"] = textureManager.setCurrentTexture(textureName);
+                }
+            });
+            return;
+        }
+    }
+    else if (command == "prefetch_textures") {
+        response["command"] = "prefetch_textures_response";
+        const Json::Value& list = root["textures"];
+        std::vector<std::string> names;
+        std::string invalid;
+        if (list.isArray()) {
+            for (const auto& name : list) {
+                if (!name.isString() || !isSafeFilename(name.asString())) {
+                    invalid = name.isString() ? name.asString() : "(non-string)";
+                    break;
+                }
+                names.push_back(name.asString());
+            }
+        }
+        if (!list.isArray() || list.empty()) {
+            response["success"] = false;
+            response["message"] = "Missing 'textures' array";
+        } else if (list.size() > MAX_PREFETCH_TEXTURES) {
+            response["success"] = false;
+            response["message"] = "At most " + std::to_string(MAX_PREFETCH_TEXTURES) + " textures";
+        } else if (!invalid.empty()) {
+            response["success"] = false;
+            response["message"] = "Invalid texture filename: " + invalid;
+        } else {
+            // Reading the image headers touches the disk, so this runs as a job;
+            // the decoding itself continues in the background after the response
+            submitJob(hdl, command, "prefetch_textures",
+                      [this, names](const std::atomic<bool>&, Json::Value& result) {
+                std::vector<std::string> queued;
+                std::vector<std::string> skipped;
+                textureManager.prefetch(names, queued, skipped);
+                result["queued"] = Json::arrayValue;
+                for (const auto& name : queued) result["queued"].append(name);
+                result["skipped"] = Json::arrayValue;
+                for (const auto& name : skipped) result["skipped"].append(name);
+                result["success"] = true;
+            });
+            return;
+        }
+    }
+    else if (command == "get_texture_cache_status") {
+        response["command"] = "texture_cache_status";
+        auto stats = textureManager.getCacheStats();
+        response["textures"] = static_cast<Json::UInt64>(stats.textures);
+        response["bytes"] = static_cast<Json::UInt64>(stats.bytes);
+        response["budgetBytes"] = static_cast<Json::UInt64>(stats.budgetBytes);
+        response["hits"] = static_cast<Json::UInt64>(stats.hits);
+        response["misses"] = static_cast<Json::UInt64>(stats.misses);
+        response["evictions"] = static_cast<Json::UInt64>(stats.evictions);
+        response["decoding"] = stats.decoding;
+        auto disk = textureManager.getDiskCacheStats();
+        response["disk"]["entries"] = static_cast<Json::UInt64>(disk.entries);
+        response["disk"]["bytes"] = static_cast<Json::UInt64>(disk.bytes);
+        response["disk"]["maxBytes"] = static_cast<Json::UInt64>(disk.maxBytes);
+        response["disk"]["hits"] = static_cast<Json::UInt64>(disk.hits);
+        response["disk"]["misses"] = static_cast<Json::UInt64>(disk.misses);
+        response["disk"]["writes"] = static_cast<Json::UInt64>(disk.writes);
+        response["disk"]["evictions"] = static_cast<Json::UInt64>(disk.evictions);
+        response["entries"] = Json::arrayValue;
+        for (const auto& entry : textureManager.getCacheEntries()) {
+            Json::Value item;
+            item["name"] = entry.name;
+            item["width"] = entry.width;
+            item["height"] = entry.height;
+            item["bytes"] = static_cast<Json::UInt64>(entry.bytes);
+            item["pinned"] = entry.pinned;
+            response["entries"].append(item);
+        }
+        response["success"] = true;
+    }
+    else if (command == "get_media_info") {
+        response["command"] = "media_info";
+        std::string file = root.get("file", "").asString();
+        bool withKeyframes = root.get("keyframes", false).asBool();
+        MediaProbeCache::MediaInfo info;
+        if (!m_probeCache) {
+            response["success"] = false;
+            response["message"] = "Media index not available";
+        } else if (file.empty()) {
+            // The whole library, as far as it has been probed
+            response["files"] = Json::arrayValue;
+            for (const auto& entry : m_probeCache->getAll()) {
+                response["files"].append(mediaInfoJson(entry, false));
+            }
+            response["pending"] = static_cast<Json::UInt64>(m_probeCache->getStats().queued);
+            response["success"] = true;
+        } else if (!isSafeFilename(file)) {
+            response["success"] = false;
+            response["message"] = "Invalid file name";
+        } else if (m_probeCache->find(file, info)) {
+            response["file"] = mediaInfoJson(info, withKeyframes);
+            response["success"] = true;
+        } else {
+            // Not probed yet: probe it now rather than wait for the background pass
+            submitJob(hdl, command, "media_info:" + file,
+                      [this, file, withKeyframes](const std::atomic<bool>&, Json::Value& result) {
+                MediaProbeCache::MediaInfo probed;
+                if (m_probeCache->findOrProbe(file, probed)) {
+                    result["file"] = mediaInfoJson(probed, withKeyframes);
+                    result["success"] = true;
+                } else {
+                    result["success"] = false;
+                    result["message"] = "Cannot read media file: " + file;
+                }
+            });
+            return;
         }
     }
     else if (command == "get_device_info") {
@@ -331,8 +1081,11 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
             response["success"] = false;
             response["message"] = "Invalid angle. Must be 0, 90, 180, or 270.";
         } else {
-            if (m_renderer) {
-                m_renderer->setRotation(angle);
+            if (applyRotation(angle)) {
+                // Decode the image on screen for the new orientation, in the background
+                m_jobs.submit("reload_texture", [this](uint64_t, const std::atomic<bool>&) {
+                    textureManager.reloadCurrent();
+                }, [](uint64_t, uint64_t) {});
             }
             if (m_config) {
                 m_config->displayRotation = angle;
@@ -419,53 +1172,77 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
                 fullSource = MEDIA_PATH + source;
             }
             bool loop = root.get("loop", true).asBool();
-            m_videoDecoder->stop();
-            m_videoDecoder->setLoop(loop);
-            if (m_videoDecoder->open(fullSource)) {
-                m_videoDecoder->start();
-                if (m_config) {
+            // Opening probes the source (up to several seconds for streams)
+            submitJob(hdl, command, "video",
+                      [this, fullSource, loop](const std::atomic<bool>& cancelled, Json::Value& result) {
+                m_videoDecoder->stop();
+                m_videoDecoder->setLoop(loop);
+                if (!m_videoDecoder->open(fullSource)) {
+                    result["success"] = false;
+                    result["message"] = "Failed to open video source";
+                } else if (cancelled) {
+                    m_videoDecoder->close();
+                    markSuperseded(result);
+                } else {
+                    m_videoDecoder->start();
+                    result["success"] = true;
+                }
+            }, [this, source, loop](const Json::Value& result) {
+                if (m_config && result["success"].asBool()) {
                     m_config->videoSource = source;
                     m_config->videoMode = true;
                     m_config->videoLoop = loop;
                 }
-                response["success"] = true;
-            } else {
-                response["success"] = false;
-                response["message"] = "Failed to open video source";
-            }
+            });
+            return;
         }
     }
     else if (command == "stop_video") {
         response["command"] = "stop_video_response";
         if (m_videoDecoder) {
-            m_videoDecoder->stop();
-            m_videoDecoder->close();
-            if (m_config) {
-                m_config->videoMode = false;
-            }
-            response["success"] = true;
+            // Queued behind (and cancelling) any play_video still opening
+            submitJob(hdl, command, "video", [this](const std::atomic<bool>&, Json::Value& result) {
+                m_videoDecoder->stop();
+                m_videoDecoder->close();
+                result["success"] = true;
+            }, [this](const Json::Value&) {
+                if (m_config) {
+                    m_config->videoMode = false;
+                }
+            });
+            return;
         } else {
             response["success"] = false;
             response["message"] = "Video decoder not available";
         }
     }
-    else if (command == "get_video_status") {
-        response["command"] = "video_status";
-        if (m_videoDecoder) {
-            response["active"] = m_videoDecoder->isActive();
-            auto info = m_videoDecoder->getSourceInfo();
-            response["source"] = info.source;
-            response["width"] = info.width;
-            response["height"] = info.height;
-            response["fps"] = info.fps;
-            response["duration"] = info.duration;
-            response["codec"] = info.codec;
-            response["success"] = true;
+    else if (command == "seek_video") {
+        response["command"] = "seek_video_response";
+        if (!m_videoDecoder) {
+            response["success"] = false;
+            response["message"] = "Video decoder not available";
+        } else if (!root.isMember("time") || !root["time"].isNumeric()) {
+            response["success"] = false;
+            response["message"] = "Missing 'time' field";
         } else {
-            response["active"] = false;
-            response["success"] = true;
+            // Only queues the seek, so it runs here rather than behind (and
+            // cancelling) a play_video still opening
+            double time = root["time"].asDouble();
+            std::string error;
+            if (m_videoDecoder->seek(time, error)) {
+                response["success"] = true;
+                response["time"] = time;
+            } else {
+                response["success"] = false;
+                response["message"] = error;
+            }
         }
     }
+    else if (command == "get_video_status") {
+        response["command"] = "video_status";
+        addVideoStatus(response, true);
+        response["success"] = true;
+    }
     else if (command == "set_playlist") {
         response["command"] = "set_playlist_response";
         if (!m_playlistController) {
@@ -497,21 +1274,29 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
             response["message"] = "No playlist set";
         } else {
             int index = root.get("index", 0).asInt();
-            m_playlistController->start(index);
-            if (m_config) {
-                m_config->videoMode = true;
-            }
-            response["success"] = true;
+            submitJob(hdl, command, "video", [this, index](const std::atomic<bool>&, Json::Value& result) {
+                m_playlistController->start(index);
+                result["success"] = true;
+            }, [this](const Json::Value&) {
+                if (m_config) {
+                    m_config->videoMode = true;
+                }
+            });
+            return;
         }
     }
     else if (command == "stop_playlist") {
         response["command"] = "stop_playlist_response";
         if (m_playlistController) {
-            m_playlistController->stop();
-            if (m_config) {
-                m_config->videoMode = false;
-            }
-            response["success"] = true;
+            submitJob(hdl, command, "video", [this](const std::atomic<bool>&, Json::Value& result) {
+                m_playlistController->stop();
+                result["success"] = true;
+            }, [this](const Json::Value&) {
+                if (m_config) {
+                    m_config->videoMode = false;
+                }
+            });
+            return;
         } else {
             response["success"] = false;
             response["message"] = "Playlist controller not available";
@@ -520,9 +1305,12 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
     else if (command == "next_video") {
         response["command"] = "next_video_response";
         if (m_playlistController && m_playlistController->isActive()) {
-            m_playlistController->next();
-            response["success"] = true;
-            response["currentIndex"] = m_playlistController->getCurrentIndex();
+            submitJob(hdl, command, "video", [this](const std::atomic<bool>&, Json::Value& result) {
+                m_playlistController->next();
+                result["success"] = true;
+                result["currentIndex"] = m_playlistController->getCurrentIndex();
+            });
+            return;
         } else {
             response["success"] = false;
             response["message"] = "No active playlist";
@@ -531,9 +1319,12 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
     else if (command == "prev_video") {
         response["command"] = "prev_video_response";
         if (m_playlistController && m_playlistController->isActive()) {
-            m_playlistController->prev();
-            response["success"] = true;
-            response["currentIndex"] = m_playlistController->getCurrentIndex();
+            submitJob(hdl, command, "video", [this](const std::atomic<bool>&, Json::Value& result) {
+                m_playlistController->prev();
+                result["success"] = true;
+                result["currentIndex"] = m_playlistController->getCurrentIndex();
+            });
+            return;
         } else {
             response["success"] = false;
             response["message"] = "No active playlist";
@@ -541,22 +1332,137 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
     }
     else if (command == "get_playlist_status") {
         response["command"] = "playlist_status";
-        if (m_playlistController) {
-            response["active"] = m_playlistController->isActive();
-            response["currentIndex"] = m_playlistController->getCurrentIndex();
-            response["currentSource"] = m_playlistController->getCurrentSource();
-            response["loop"] = m_playlistController->isLooping();
-            response["videos"] = Json::arrayValue;
-            for (const auto& v : m_playlistController->getPlaylist()) {
-                response["videos"].append(v);
+        addPlaylistStatus(response);
+        response["success"] = true;
+    }
+#endif
+    // --- Batched scene changes ---
+    else if (command == "batch") {
+        response["command"] = "batch_response";
+        const Json::Value& commands = root["commands"];
+        if (!commands.isArray() || commands.empty()) {
+            response["success"] = false;
+            response["message"] = "Missing 'commands' array";
+        } else if (commands.size() > MAX_BATCH_COMMANDS) {
+            response["success"] = false;
+            response["message"] = "At most " + std::to_string(MAX_BATCH_COMMANDS) + " commands per batch";
+        } else {
+            // Validate everything up front; one bad entry rejects the batch
+            auto steps = std::make_shared<std::vector<BatchStep>>(commands.size());
+            response["results"] = Json::arrayValue;
+            bool valid = true;
+            for (Json::ArrayIndex i = 0; i < commands.size(); i++) {
+                Json::Value result;
+                result["command"] = commands[i]["command"].asString();
+                std::string error;
+                if (buildBatchStep(commands[i], (*steps)[i], error)) {
+                    result["success"] = true;
+                } else {
+                    result["success"] = false;
+                    result["message"] = error;
+                    valid = false;
+                }
+                response["results"].append(result);
+            }
+            if (valid) {
+                // A batch that stops the decoder queues with the video jobs,
+                // so it never runs alongside a play_video on the same decoder
+                bool video = std::any_of(steps->begin(), steps->end(), [](const BatchStep& step) { return step.video; });
+                submitJob(hdl, command, video ? "video" : "batch", [this, steps](const std::atomic<bool>& cancelled, Json::Value& result) {
+                    runBatch(*steps, cancelled, result);
+                }, [this, steps](const Json::Value& result) {
+                    if (!m_config || !result["success"].asBool()) return;
+                    bool changed = false;
+                    for (const auto& step : *steps) {
+                        if (step.commit) {
+                            step.commit();
+                            changed = true;
+                        }
+                    }
+                    if (changed) m_config->saveToFile();
+                });
+                return;
+            }
+            response["success"] = false;
+            response["message"] = "Batch rejected; nothing was applied";
+        }
+    }
+    // --- Event subscriptions ---
+    else if (command == "subscribe" || command == "unsubscribe") {
+        response["command"] = command + "_response";
+        const Json::Value& topics = root["topics"];
+        std::string unknown;
+        if (topics.isArray()) {
+            for (const auto& topic : topics) {
+                if (!topic.isString() || !isEventTopic(topic.asString())) {
+                    unknown = topic.isString() ? topic.asString() : "(non-string)";
+                    break;
+                }
+            }
+        }
+        if (!topics.isArray() || topics.empty()) {
+            response["success"] = false;
+            response["message"] = "Missing 'topics' array";
+        } else if (!unknown.empty()) {
+            response["success"] = false;
+            response["message"] = "Unknown topic: " + unknown;
+        } else {
+            auto& subscriber = m_subscriptions[hdl];
+            for (const auto& topic : topics) {
+                if (command == "subscribe") {
+                    subscriber.topics.insert(topic.asString());
+                } else {
+                    subscriber.topics.erase(topic.asString());
+                    subscriber.sent.erase(topic.asString());
+                }
+            }
+            response["topics"] = Json::arrayValue;
+            for (const auto& topic : subscriber.topics) {
+                response["topics"].append(topic);
             }
             response["success"] = true;
+            // State topics start with a full snapshot on the next poll
+        }
+    }
+    // --- Preview thumbnails ---
+    else if (command == "subscribe_preview") {
+        response["command"] = "subscribe_preview_response";
+        int fps = root.get("fps", DEFAULT_PREVIEW_FPS).asInt();
+        int width = root.get("width", DEFAULT_PREVIEW_WIDTH).asInt();
+        if (!m_previewStream || !PreviewStream::isSupported()) {
+            response["success"] = false;
+            response["message"] = "Preview not available (built without libjpeg)";
+        } else if (!m_renderer || !m_renderer->supportsOutputCapture()) {
+            response["success"] = false;
+            response["message"] = "Preview needs an OpenGL renderer";
+        } else if (fps < 1 || fps > PreviewStream::MAX_FPS) {
+            response["success"] = false;
+            response["message"] = "fps must be between 1 and " + std::to_string(PreviewStream::MAX_FPS);
+        } else if (width < PreviewStream::MIN_WIDTH || width > PreviewStream::MAX_WIDTH) {
+            response["success"] = false;
+            response["message"] = "width must be between " + std::to_string(PreviewStream::MIN_WIDTH) +
+                                  " and " + std::to_string(PreviewStream::MAX_WIDTH);
         } else {
-            response["active"] = false;
+            auto& client = m_previewClients[hdl];
+            client.fps = fps;
+            client.width = width;
+            updatePreviewDemand();
+            response["fps"] = fps;
+            response["width"] = width;
             response["success"] = true;
         }
     }
-#endif
+    else if (command == "unsubscribe_preview") {
+        response["command"] = "unsubscribe_preview_response";
+        auto client = m_previewClients.find(hdl);
+        if (client != m_previewClients.end()) {
+            response["framesSent"] = static_cast<Json::UInt64>(client->second.framesSent);
+            response["framesDropped"] = static_cast<Json::UInt64>(client->second.framesDropped);
+            m_previewClients.erase(client);
+            updatePreviewDemand();
+        }
+        response["success"] = true;
+    }
     // --- NDI commands ---
     else if (command == "scan_ndi_sources") {
         response["command"] = "ndi_sources";
@@ -597,13 +1503,157 @@ void WebSocketServer::onMessage(websocketpp::connection_hdl hdl, wsserver::messa
     }
     else if (command == "get_ndi_status") {
         response["command"] = "ndi_status";
-        if (m_ndiReceiver) {
-            response["connected"] = m_ndiReceiver->isConnected();
-            response["source"] = m_ndiReceiver->getCurrentSourceName();
+        addNdiStatus(response);
+        response["success"] = true;
+    }
+    else if (command == "set_ndi_multiview") {
+        response["command"] = "set_ndi_multiview_response";
+        const Json::Value& sources = root["sources"];
+        std::string layout = root.get("layout", "").asString();
+        int columns = (layout == "2x2") ? 2 : (layout == "3x3") ? 3 : 0;
+        if (!m_ndiMultiview || !m_ndiReceiver || !m_ndiReceiver->isRuntimeLoaded()) {
+            response["success"] = false;
+            response["message"] = "NDI runtime not installed. Place libndi.so in /data/lib/";
+        } else if (!sources.isArray()) {
+            response["success"] = false;
+            response["message"] = "Missing 'sources' array";
+        } else if (!layout.empty() && columns == 0) {
+            response["success"] = false;
+            response["message"] = "Layout must be 2x2 or 3x3";
         } else {
-            response["connected"] = false;
-            response["source"] = "";
+            std::vector<std::string> names;
+            for (const auto& source : sources) {
+                names.push_back(source.asString());
+            }
+            int width = m_renderer ? m_renderer->getWidth() : 0;
+            int height = m_renderer ? m_renderer->getHeight() : 0;
+            // Replacing a running multiview joins every old tile's receiver
+            submitJob(hdl, command, "ndi_multiview",
+                      [this, names, columns, width, height, sources](const std::atomic<bool>&, Json::Value& result) {
+                std::string error;
+                int layoutColumns = columns;
+                if (m_ndiMultiview->start(names, layoutColumns, width, height, error)) {
+                    int rows = 0;
+                    m_ndiMultiview->getStatus(layoutColumns, rows);
+                    result["success"] = true;
+                    result["layout"] = std::to_string(layoutColumns) + "x" + std::to_string(rows);
+                    result["sources"] = sources;
+                } else {
+                    result["success"] = false;
+                    result["message"] = error;
+                }
+            }, [this, names](const Json::Value& result) {
+                if (m_config && result["success"].asBool()) {
+                    m_config->ndiMultiviewSources = names;
+                    m_config->ndiMultiviewColumns = std::stoi(result["layout"].asString());  // "NxN"
+                    m_config->saveToFile();
+                }
+            });
+            return;
         }
+    }
+    else if (command == "stop_ndi_multiview") {
+        response["command"] = "stop_ndi_multiview_response";
+        if (m_ndiMultiview) {
+            submitJob(hdl, command, "ndi_multiview", [this](const std::atomic<bool>&, Json::Value& result) {
+                m_ndiMultiview->stop();
+                result["success"] = true;
+            }, [this](const Json::Value&) {
+                if (m_config) {
+                    m_config->ndiMultiviewSources.clear();
+                    m_config->saveToFile();
+                }
+            });
+            return;
+        } else {
+            response["success"] = false;
+            response["message"] = "NDI multiview not available";
+        }
+    }
+    else if (command == "get_ndi_multiview_status") {
+        response["command"] = "ndi_multiview_status";
+        response["tiles"] = Json::arrayValue;
+        int columns = 0;
+        int rows = 0;
+        if (m_ndiMultiview) {
+            auto tiles = m_ndiMultiview->getStatus(columns, rows);
+            for (size_t i = 0; i < tiles.size(); i++) {
+                Json::Value tile;
+                tile["index"] = static_cast<int>(i);
+                tile["source"] = tiles[i].source;
+                tile["connected"] = tiles[i].connected;
+                tile["width"] = tiles[i].stats.width;
+                tile["height"] = tiles[i].stats.height;
+                tile["fps"] = tiles[i].stats.fps;
+                tile["framesReceived"] = static_cast<Json::UInt64>(tiles[i].stats.framesReceived);
+                tile["framesDropped"] = static_cast<Json::Int64>(tiles[i].stats.framesDropped);
+                tile["lowBandwidth"] = tiles[i].stats.lowBandwidth;
+                response["tiles"].append(tile);
+            }
+        }
+        response["active"] = columns > 0;
+        response["layout"] = columns > 0 ? std::to_string(columns) + "x" + std::to_string(rows) : "";
+        response["success"] = true;
+    }
+    else if (command == "start_ndi_output") {
+        response["command"] = "start_ndi_output_response";
+        if (!m_ndiSender || !m_ndiReceiver || !m_ndiReceiver->isRuntimeLoaded()) {
+            response["success"] = false;
+            response["message"] = "NDI runtime not installed. Place libndi.so in /data/lib/";
+        } else if (!m_renderer || !m_renderer->supportsOutputCapture()) {
+            response["success"] = false;
+            response["message"] = "Renderer cannot capture its output";
+        } else {
+            std::string name = root.get("name", m_config ? m_config->ndiOutputName : "Rendermatic").asString();
+            int width = root.get("width", m_config ? m_config->ndiOutputWidth : 640).asInt();
+            int height = root.get("height", m_config ? m_config->ndiOutputHeight : 360).asInt();
+            int fps = root.get("fps", m_config ? m_config->ndiOutputFps : 15).asInt();
+            std::string error;
+            if (m_ndiSender->start(name, width, height, fps, error)) {
+                if (m_config) {
+                    m_config->ndiOutputEnabled = true;
+                    m_config->ndiOutputName = name;
+                    m_config->ndiOutputWidth = width;
+                    m_config->ndiOutputHeight = height;
+                    m_config->ndiOutputFps = fps;
+                    m_config->saveToFile();
+                }
+                response["success"] = true;
+                response["name"] = name;
+                response["width"] = width;
+                response["height"] = height;
+                response["fps"] = fps;
+            } else {
+                response["success"] = false;
+                response["message"] = error;
+            }
+        }
+    }
+    else if (command == "stop_ndi_output") {
+        response["command"] = "stop_ndi_output_response";
+        if (m_ndiSender) {
+            m_ndiSender->stop();
+            if (m_config) {
+                m_config->ndiOutputEnabled = false;
+                m_config->saveToFile();
+            }
+            response["success"] = true;
+        } else {
+            response["success"] = false;
+            response["message"] = "NDI output not available";
+        }
+    }
+    else if (command == "get_ndi_output_status") {
+        response["command"] = "ndi_output_status";
+        NDISender::Status status;
+        if (m_ndiSender) status = m_ndiSender->getStatus();
+        response["active"] = status.active;
+        response["name"] = status.name;
+        response["width"] = status.width;
+        response["height"] = status.height;
+        response["fps"] = status.fps;
+        response["connections"] = status.connections;
+        response["framesSent"] = static_cast<Json::UInt64>(status.framesSent);
         response["success"] = true;
     }
     else if (command == "stop_ndi") {
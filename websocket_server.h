@@ -4,15 +4,26 @@
 #include <websocketpp/server.hpp>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <functional>
+#include <map>
+#include <memory>
+#include <set>
 #include <json/json.h>
 #include "texture_manager.h"
+#include "media_probe_cache.h"
 #include "auth_manager.h"
 #include "irenderer.h"
+#include "job_queue.h"
+#include "render_stats.h"
+#include "frame_boundary.h"
 
 class MDNSAdvertiser;
 class SplashController;
 class NDIReceiver;
+class NDIMultiview;
+class NDISender;
+class PreviewStream;
 struct Configuration;
 #ifdef HAVE_FFMPEG
 class VideoDecoder;
@@ -33,7 +44,13 @@ public:
     void setMDNSAdvertiser(MDNSAdvertiser* advertiser) { m_advertiser = advertiser; }
     void setSplashController(SplashController* controller) { m_splashController = controller; }
     void setRenderer(IRenderer* renderer) { m_renderer = renderer; }
-    void setNDIReceiver(NDIReceiver* ndi) { m_ndiReceiver = ndi; }
+    void setNDIReceiver(NDIReceiver* ndi);
+    void setNDIMultiview(NDIMultiview* multiview) { m_ndiMultiview = multiview; }
+    void setNDISender(NDISender* sender) { m_ndiSender = sender; }
+    void setPreviewStream(PreviewStream* preview);
+    void setRenderStats(const RenderStats* stats) { m_renderStats = stats; }
+    // Batches are applied here, between two rendered frames
+    void setFrameBoundary(FrameBoundary* boundary) { m_frameBoundary = boundary; }
     
     // Set configuration for device info, name persistence, and auth key loading
     void setConfiguration(Configuration* config);
@@ -47,17 +64,75 @@ public:
     // Update instance name (updates mDNS and config)
     bool setInstanceName(const std::string& newName);
 
-    // Scan media directory for video files
-    std::vector<std::string> scanVideos();
+    // Image and video lists come from here; scan_* commands rescan it
+    void setMediaIndex(MediaIndex* index) { m_mediaIndex = index; }
+    // Answers get_media_info
+    void setMediaProbeCache(MediaProbeCache* cache) { m_probeCache = cache; }
+    // Push a library change to `media` subscribers. Safe from any thread.
+    void publishMediaChange(const MediaIndex::Change& change);
 
 private:
     void run();
     void onOpen(websocketpp::connection_hdl hdl);
     void onClose(websocketpp::connection_hdl hdl);
     void onMessage(websocketpp::connection_hdl hdl, wsserver::message_ptr msg);
+    // Plain HTTP requests on the WebSocket port: GET /metrics (Prometheus text format)
+    void onHttp(websocketpp::connection_hdl hdl);
+    std::string metricsText() const;
     void sendJson(websocketpp::connection_hdl hdl, const Json::Value& response);
+    // Like sendJson, but safe from any thread; delivery happens on the ASIO thread
+    void sendJsonAsync(websocketpp::connection_hdl hdl, const Json::Value& response);
 
-    std::vector<std::string> m_availableVideos;
+    // Run a slow command on the job queue. The client gets an immediate
+    // {"command":"accepted","jobId":N} and later the usual <command>_response
+    // carrying the same jobId. `work` fills in the response on a worker thread;
+    // `commit` then runs on the ASIO thread (config changes belong there).
+    // A newer job with the same key cancels this one.
+    using JobWork = std::function<void(const std::atomic<bool>& cancelled, Json::Value& result)>;
+    using JobCommit = std::function<void(const Json::Value& result)>;
+    void submitJob(websocketpp::connection_hdl hdl, const std::string& command,
+                   const std::string& key, JobWork work, JobCommit commit = nullptr);
+
+    // Push an event to every connection subscribed to `topic`. Safe to call
+    // from any thread; delivery happens on the ASIO thread.
+    void publish(const std::string& topic, const Json::Value& event);
+
+    // One command of a `batch`: `prepare` runs first on a worker (may fail and
+    // abort the batch), `apply` runs at the frame boundary, `commit` updates the
+    // configuration on the ASIO thread afterwards
+    // Only `apply` runs on the render thread, so it must not block: it swaps
+    // what the next frame shows. Everything slow happens on the job worker.
+    struct BatchStep {
+        std::string command;
+        std::function<bool(std::string& error)> prepare;   // may fail; nothing visible yet
+        std::function<void()> stage;    // blocking side effects, once every step has prepared
+        std::function<void(Json::Value& result)> apply;
+        std::function<void()> finish;   // follow-up work after the frame
+        std::function<void()> commit;
+        bool video = false;             // stops the video decoder
+    };
+    bool buildBatchStep(const Json::Value& request, BatchStep& step, std::string& error);
+    void runBatch(std::vector<BatchStep>& steps, const std::atomic<bool>& cancelled, Json::Value& result);
+
+    // Status objects shared by the get_*_status commands and state topics
+    void addVideoStatus(Json::Value& out, bool withTestPattern) const;
+    void addPlaylistStatus(Json::Value& out) const;
+    void addNdiStatus(Json::Value& out) const;
+    Json::Value stateSnapshot(const std::string& topic) const;
+
+    // State topics: poll on the ASIO thread and push per-connection deltas
+    void scheduleStatePoll();
+    void pollState();
+
+    // Preview thumbnails: the stream runs at the highest rate and width any
+    // subscriber asked for; each image then goes to the subscribers that are
+    // due one and are keeping up with their socket
+    void updatePreviewDemand();
+    void deliverPreview(const std::shared_ptr<const std::string>& jpeg);
+
+    // Rotate the display and re-target still image decoding to match.
+    // True if the target size changed, so the current image wants reloading.
+    bool applyRotation(int angle);
 
     wsserver server;
     std::thread serverThread;
@@ -68,8 +143,38 @@ private:
     SplashController* m_splashController = nullptr;
     IRenderer* m_renderer = nullptr;
     NDIReceiver* m_ndiReceiver = nullptr;
+    NDIMultiview* m_ndiMultiview = nullptr;
+    NDISender* m_ndiSender = nullptr;
+    PreviewStream* m_previewStream = nullptr;
+    const RenderStats* m_renderStats = nullptr;
+    FrameBoundary* m_frameBoundary = nullptr;
     Configuration* m_config = nullptr;
+    MediaIndex* m_mediaIndex = nullptr;
+    MediaProbeCache* m_probeCache = nullptr;
     AuthManager m_auth;
+
+    // Event topics per connection; only touched on the ASIO thread
+    struct Subscriber {
+        std::set<std::string> topics;
+        std::map<std::string, Json::Value> sent;   // last state pushed per state topic
+    };
+    std::map<websocketpp::connection_hdl, Subscriber,
+             std::owner_less<websocketpp::connection_hdl>> m_subscriptions;
+    std::unique_ptr<asio::steady_timer> m_stateTimer;
+
+    // Preview subscribers; only touched on the ASIO thread
+    struct PreviewClient {
+        int fps = 0;
+        int width = 0;
+        std::chrono::steady_clock::time_point nextFrame;
+        uint64_t framesSent = 0;
+        uint64_t framesDropped = 0;   // skipped because the connection was backed up
+    };
+    std::map<websocketpp::connection_hdl, PreviewClient,
+             std::owner_less<websocketpp::connection_hdl>> m_previewClients;
+
+    // Slow commands (video open, image decode, multiview start-up)
+    JobQueue m_jobs;
 #ifdef HAVE_FFMPEG
     VideoDecoder* m_videoDecoder = nullptr;
     PlaylistController* m_playlistController = nullptr;